@@ -0,0 +1,92 @@
+// Ancestor query benchmark: smallest shape containing random pairs of pixels, with the ancestor
+// index against a walk up the parent links, checking that both agree.
+#include "ancestor_index.h"
+#include "node_table.h"
+#include "svm_img.h"
+#include "tos.h"
+#include <Common/Image.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double elapsed(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    const char *filename = argc > 1 ? argv[1] : "test/262000-pepperAndSalt.pgm";
+    std::size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+
+    LibTIM::Image<LibTIM::U8> im;
+    if (!LibTIM::Image<LibTIM::U8>::load(filename, im))
+    {
+        return EXIT_FAILURE;
+    }
+    std::size_t pixels = static_cast<std::size_t>(im.getSizeX()) * im.getSizeY();
+
+    SVMImage<LibTIM::U8> svm_img(im);
+    TOS<LibTIM::U8> tree(svm_img);
+    svm_img.uninterpolate(&tree);
+    NodeTable<LibTIM::U8> nodes(tree);
+
+    auto start = Clock::now();
+    AncestorIndex<LibTIM::U8> index(nodes);
+    double build = elapsed(start);
+
+    std::size_t maxDepth = 0;
+    for (NodeIndex n = 0; n < nodes.size(); n++)
+    {
+        maxDepth = std::max(maxDepth, nodes.depth(n));
+    }
+    std::cout << filename << ": " << nodes.size() << " shapes, depth up to " << maxDepth << ", index built in " << build << " ms" << std::endl;
+
+    std::mt19937_64 rng(0);
+    std::uniform_int_distribution<std::size_t> pixel(0, pixels - 1);
+    std::vector<std::size_t> first(queries), second(queries);
+    for (std::size_t i = 0; i < queries; i++)
+    {
+        first[i] = pixel(rng);
+        second[i] = pixel(rng);
+    }
+
+    std::vector<NodeIndex> result(queries), expected(queries);
+    start = Clock::now();
+    index.lca(first.data(), second.data(), queries, result.data());
+    double batch = elapsed(start);
+
+    start = Clock::now();
+    for (std::size_t i = 0; i < queries; i++)
+    {
+        NodeIndex a = index.pixelNode(first[i]), b = index.pixelNode(second[i]);
+        while (nodes.depth(a) > nodes.depth(b))
+            a = nodes.parent(a);
+        while (nodes.depth(b) > nodes.depth(a))
+            b = nodes.parent(b);
+        while (a != b)
+        {
+            a = nodes.parent(a);
+            b = nodes.parent(b);
+        }
+        expected[i] = a;
+    }
+    double walk = elapsed(start);
+
+    bool same = result == expected;
+    for (std::size_t i = 0; i < queries && same; i++)
+    {
+        // the lca contains both pixels, and is their ancestor at its own depth
+        NodeIndex a = index.pixelNode(first[i]);
+        same = nodes.isAncestor(result[i], a) && index.ancestor(a, nodes.depth(result[i])) == result[i];
+    }
+
+    std::cout << queries << " pairs: index " << batch << " ms (" << batch * 1e6 / queries << " ns per pair), parent walk " << walk
+              << " ms (" << walk * 1e6 / queries << " ns per pair)" << std::endl
+              << (same ? "results match" : "RESULTS DIFFER") << std::endl;
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,309 @@
+// Scaling benchmark: full tree of shapes pipeline on every image of a directory (test/ by default).
+// For each image and each number of tiles, reports the median and 95th percentile of each stage over
+// several runs and the throughput, then fits the empirical complexity t ~ n^k over the images.
+// With a baseline file, fails if the throughput of an image dropped by more than the threshold.
+#include "profiler.h"
+#include "svm_img.h"
+#include "tos.h"
+#include <Common/Image.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// stages reported in the table, in pipeline order
+static const char *STAGES[] = {"extend", "interpolate", "sort", "unionFind", "canonize", "uninterpolate"};
+
+struct Measure
+{
+    std::string file;
+    std::size_t pixels;
+    unsigned int jobs;
+    std::map<std::string, std::vector<double>> stages; // wall time of each run, per stage
+    std::vector<double> total;
+};
+
+void help()
+{
+    std::cout << "Usage: corpus [options] [dir]\n\n"
+              << " -n, --runs <n>             Runs per image (default 5)\n"
+              << " -t, --threads <list>       Numbers of tiles to compare, e.g. 1,2,4 (default 1)\n"
+              << " -m, --max-pixels <n>       Skip the images larger than <n> pixels\n"
+              << " -b, --baseline <file>      Compare the throughput to <file>\n"
+              << " -s, --save-baseline <file> Write the throughput of each image to <file>\n"
+              << " -r, --threshold <ratio>    Allowed throughput drop against the baseline (default 0.1)\n"
+              << std::endl;
+}
+
+double percentile(std::vector<double> values, double p)
+{
+    std::sort(values.begin(), values.end());
+    std::size_t rank = static_cast<std::size_t>(std::ceil(p * values.size()));
+    return values[std::max<std::size_t>(rank, 1) - 1];
+}
+
+std::vector<std::string> images(const std::string &dir)
+{
+    std::vector<std::string> files;
+    if (DIR *d = opendir(dir.c_str()))
+    {
+        while (struct dirent *entry = readdir(d))
+        {
+            std::string name = entry->d_name;
+            if (name.size() > 4 && name.substr(name.size() - 4) == ".pgm")
+            {
+                files.push_back(dir + "/" + name);
+            }
+        }
+        closedir(d);
+    }
+    return files;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string dir = "test";
+    unsigned int runs = 5;
+    std::vector<unsigned int> threads = {1};
+    std::size_t maxPixels = 0;
+    const char *baselineFile = nullptr;
+    const char *saveFile = nullptr;
+    double threshold = 0.1;
+
+    static struct option long_options[] = {
+        {"runs", required_argument, nullptr, 'n'},
+        {"threads", required_argument, nullptr, 't'},
+        {"max-pixels", required_argument, nullptr, 'm'},
+        {"baseline", required_argument, nullptr, 'b'},
+        {"save-baseline", required_argument, nullptr, 's'},
+        {"threshold", required_argument, nullptr, 'r'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}};
+
+    int c;
+    while ((c = getopt_long(argc, argv, "n:t:m:b:s:r:h", long_options, nullptr)) != -1)
+    {
+        switch (c)
+        {
+        case 'n':
+            runs = std::max(1, atoi(optarg));
+            break;
+        case 't':
+        {
+            threads.clear();
+            std::stringstream list(optarg);
+            std::string item;
+            while (std::getline(list, item, ','))
+            {
+                threads.push_back(std::max(1, atoi(item.c_str())));
+            }
+            break;
+        }
+        case 'm':
+            maxPixels = std::strtoull(optarg, nullptr, 10);
+            break;
+        case 'b':
+            baselineFile = optarg;
+            break;
+        case 's':
+            saveFile = optarg;
+            break;
+        case 'r':
+            threshold = atof(optarg);
+            break;
+        case 'h':
+            help();
+            return EXIT_SUCCESS;
+        default:
+            help();
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind < argc)
+    {
+        dir = argv[optind];
+    }
+
+    // load the corpus, smallest images first
+    std::vector<std::pair<std::string, LibTIM::Image<LibTIM::U8>>> corpus;
+    for (const std::string &file : images(dir))
+    {
+        LibTIM::Image<LibTIM::U8> im;
+        if (!LibTIM::Image<LibTIM::U8>::load(file.c_str(), im))
+        {
+            continue;
+        }
+        std::size_t pixels = static_cast<std::size_t>(im.getSizeX()) * im.getSizeY();
+        if (maxPixels == 0 || pixels <= maxPixels)
+        {
+            corpus.push_back(std::make_pair(file, im));
+        }
+    }
+    std::sort(corpus.begin(), corpus.end(), [](const std::pair<std::string, LibTIM::Image<LibTIM::U8>> &a, const std::pair<std::string, LibTIM::Image<LibTIM::U8>> &b) {
+        return a.second.getSizeX() * static_cast<std::size_t>(a.second.getSizeY()) < b.second.getSizeX() * static_cast<std::size_t>(b.second.getSizeY());
+    });
+    if (corpus.empty())
+    {
+        std::cout << "No PGM image in " << dir << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Profiler::instance().enable(true);
+    std::vector<Measure> measures;
+
+    std::cout << std::left << std::setw(36) << "image" << std::right << std::setw(10) << "pixels" << std::setw(6) << "jobs";
+    for (const char *stage : STAGES)
+    {
+        std::cout << std::setw(14) << stage;
+    }
+    std::cout << std::setw(12) << "total" << std::setw(10) << "p95" << std::setw(10) << "Mpx/s" << "\n";
+    std::cout << std::left << std::setw(52) << "" << std::right << "(median ms)\n";
+
+    for (auto &entry : corpus)
+    {
+        for (unsigned int jobs : threads)
+        {
+            Measure m;
+            m.file = entry.first.substr(entry.first.rfind('/') + 1);
+            m.pixels = static_cast<std::size_t>(entry.second.getSizeX()) * entry.second.getSizeY();
+            m.jobs = jobs;
+
+            for (unsigned int run = 0; run < runs; run++)
+            {
+                Profiler::instance().reset();
+                auto start = std::chrono::steady_clock::now();
+                {
+                    SVMImage<LibTIM::U8> svm_img(entry.second);
+                    TOS<LibTIM::U8> tree(svm_img, jobs);
+                    svm_img.uninterpolate(&tree);
+                }
+                m.total.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                for (const Profiler::Stage &stage : Profiler::instance().stages())
+                {
+                    m.stages[stage.name].push_back(stage.wall);
+                }
+            }
+            BufferPool::instance().release();
+
+            std::cout << std::left << std::setw(36) << m.file << std::right << std::setw(10) << m.pixels << std::setw(6) << jobs
+                      << std::fixed << std::setprecision(1);
+            for (const char *stage : STAGES)
+            {
+                std::cout << std::setw(14) << percentile(m.stages[stage], 0.5);
+            }
+            double median = percentile(m.total, 0.5);
+            std::cout << std::setw(12) << median << std::setw(10) << percentile(m.total, 0.95) << std::setw(10)
+                      << std::setprecision(2) << m.pixels / median / 1e3 << std::endl;
+            measures.push_back(m);
+        }
+    }
+
+    // empirical complexity: least squares fit of log(t) = k log(n) + b, on the images large enough
+    // for the timings to be meaningful
+    std::cout << "\n";
+    for (unsigned int jobs : threads)
+    {
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        int count = 0;
+        for (const Measure &m : measures)
+        {
+            if (m.jobs != jobs || m.pixels < 10000)
+            {
+                continue;
+            }
+            double x = std::log(static_cast<double>(m.pixels));
+            double y = std::log(percentile(m.total, 0.5));
+            sx += x;
+            sy += y;
+            sxx += x * x;
+            sxy += x * y;
+            count++;
+        }
+        // at least two distinct sizes are needed
+        double variance = count * sxx - sx * sx;
+        if (count < 2 || variance < 1e-6)
+        {
+            continue;
+        }
+        double k = (count * sxy - sx * sy) / variance;
+        std::cout << "jobs " << jobs << ": time ~ n^" << std::setprecision(2) << k << " over " << count << " images"
+                  << (k > 1.25 ? " (not quasi-linear!)" : " (quasi-linear)") << "\n";
+    }
+
+    // thread scaling against the first number of tiles
+    if (threads.size() > 1)
+    {
+        double reference = 0;
+        std::map<unsigned int, double> totals;
+        for (const Measure &m : measures)
+        {
+            totals[m.jobs] += percentile(m.total, 0.5);
+        }
+        reference = totals[threads[0]];
+        for (unsigned int jobs : threads)
+        {
+            std::cout << "jobs " << jobs << ": speedup x" << std::setprecision(2) << reference / totals[jobs] << "\n";
+        }
+    }
+
+    if (saveFile)
+    {
+        std::ofstream out(saveFile);
+        out << "# image jobs pixels/s\n";
+        for (const Measure &m : measures)
+        {
+            out << m.file << " " << m.jobs << " " << std::setprecision(0) << m.pixels / percentile(m.total, 0.5) * 1e3 << "\n";
+        }
+        std::cout << "baseline written to " << saveFile << "\n";
+    }
+
+    int status = EXIT_SUCCESS;
+    if (baselineFile)
+    {
+        std::ifstream in(baselineFile);
+        if (!in)
+        {
+            std::cout << "Cannot read baseline " << baselineFile << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::map<std::pair<std::string, unsigned int>, double> baseline;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::stringstream ss(line);
+            std::string file;
+            unsigned int jobs;
+            double throughput;
+            if (line[0] != '#' && ss >> file >> jobs >> throughput)
+            {
+                baseline[std::make_pair(file, jobs)] = throughput;
+            }
+        }
+        for (const Measure &m : measures)
+        {
+            auto it = baseline.find(std::make_pair(m.file, m.jobs));
+            if (it == baseline.end())
+            {
+                continue;
+            }
+            double throughput = m.pixels / percentile(m.total, 0.5) * 1e3;
+            if (throughput < (1 - threshold) * it->second)
+            {
+                std::cout << "REGRESSION " << m.file << " (" << m.jobs << " jobs): " << std::setprecision(0) << throughput
+                          << " px/s, baseline " << it->second << " px/s\n";
+                status = EXIT_FAILURE;
+            }
+        }
+        std::cout << (status == EXIT_SUCCESS ? "no regression" : "throughput regression") << " against " << baselineFile
+                  << " (threshold " << std::setprecision(0) << threshold * 100 << "%)" << std::endl;
+    }
+    return status;
+}
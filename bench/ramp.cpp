@@ -0,0 +1,74 @@
+// Regression benchmark: tree of shapes of a synthetic diagonal ramp.
+// A ramp gives long degenerate chains in the union-find, which used to overflow
+// the stack with the recursive findRoot.
+// The memory grows linearly with the pixels, about 330 MB per megapixel: the default 2000x2000 ramp
+// fits on a usual machine, larger ones are run with -s <w>x<h> (or <width> [<height>]).
+#include "svm_img.h"
+#include "tos.h"
+#include <Common/Image.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char *argv[])
+{
+    LibTIM::TSize width = 2000;
+    LibTIM::TSize height = 2000;
+    bool implicit = false;
+    unsigned int jobs = 1;
+
+    int pos = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-i") || !strcmp(argv[i], "--implicit"))
+        {
+            implicit = true;
+        }
+        else if ((!strcmp(argv[i], "-j") || !strcmp(argv[i], "--jobs")) && i + 1 < argc)
+        {
+            jobs = atoi(argv[++i]);
+        }
+        else if ((!strcmp(argv[i], "-s") || !strcmp(argv[i], "--size")) && i + 1 < argc)
+        {
+            unsigned int w, h;
+            if (sscanf(argv[++i], "%ux%u", &w, &h) != 2 || w < 2 || h < 2)
+            {
+                std::cerr << "Invalid size: " << argv[i] << std::endl;
+                return EXIT_FAILURE;
+            }
+            width = w;
+            height = h;
+        }
+        else if (pos == 0)
+        {
+            width = height = atoi(argv[i]);
+            pos++;
+        }
+        else
+        {
+            height = atoi(argv[i]);
+        }
+    }
+
+    std::cout << "ramp " << width << "x" << height << (implicit ? " (implicit)" : "") << ", " << jobs << " job(s)" << std::endl;
+
+    LibTIM::Image<LibTIM::U8> im(width, height);
+    for (LibTIM::TSize y = 0; y < height; y++)
+    {
+        for (LibTIM::TSize x = 0; x < width; x++)
+        {
+            im(x, y) = static_cast<LibTIM::U8>((static_cast<std::size_t>(x) + y) * 255 / (width + height - 2));
+        }
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    SVMImage<LibTIM::U8> svm_img(im, implicit);
+    TOS<LibTIM::U8> tree(svm_img, jobs);
+    svm_img.uninterpolate(&tree);
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Tree computation executed in " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() << " milliseconds" << std::endl;
+    return 0;
+}
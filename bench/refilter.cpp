@@ -0,0 +1,104 @@
+// Interactive filtering benchmark: an area slider swept over a resident tree of shapes.
+// Compares each incremental update to a full grain filter and reconstruction, and checks that both
+// give the same image and that the update reports exactly the pixels whose value changed.
+#include "attributes.h"
+#include "filter.h"
+#include "node_table.h"
+#include "svm_img.h"
+#include "tos.h"
+#include <Common/Image.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double elapsed(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    const char *filename = argc > 1 ? argv[1] : "test/262000-pepperAndSalt.pgm";
+    unsigned int steps = argc > 2 ? std::max(2, atoi(argv[2])) : 50;
+
+    LibTIM::Image<LibTIM::U8> im;
+    if (!LibTIM::Image<LibTIM::U8>::load(filename, im))
+    {
+        return EXIT_FAILURE;
+    }
+    std::size_t pixels = static_cast<std::size_t>(im.getSizeX()) * im.getSizeY();
+
+    auto start = Clock::now();
+    SVMImage<LibTIM::U8> svm_img(im);
+    TOS<LibTIM::U8> tree(svm_img);
+    svm_img.uninterpolate(&tree);
+    NodeTable<LibTIM::U8> nodes(tree);
+    Attributes<LibTIM::U8> attributes(nodes);
+    double build = elapsed(start);
+
+    start = Clock::now();
+    IncrementalFilter<LibTIM::U8> slider(attributes, FilterCriterion::Area);
+    double index = elapsed(start);
+
+    std::cout << filename << ": " << pixels << " pixels, " << nodes.size() << " shapes" << std::endl
+              << "tree and attributes " << build << " ms, slider index " << index << " ms" << std::endl;
+
+    // geometric sweep of the area up to the whole image, then back down
+    std::vector<double> thresholds;
+    for (unsigned int i = 0; i < steps; i++)
+    {
+        thresholds.push_back(std::floor(std::pow(static_cast<double>(pixels), static_cast<double>(i) / (steps - 1))));
+    }
+    for (unsigned int i = steps - 1; i-- > 0;)
+    {
+        thresholds.push_back(thresholds[i]);
+    }
+
+    LibTIM::Image<LibTIM::U8> filtered, reference, previous;
+    std::vector<double> updates, fulls;
+    std::size_t updatedPixels = 0;
+    bool same = true;
+    for (std::size_t i = 0; i < thresholds.size(); i++)
+    {
+        start = Clock::now();
+        updatedPixels += slider.setThreshold(thresholds[i], filtered);
+        if (i > 0)
+        {
+            updates.push_back(elapsed(start));
+
+            std::size_t differ = 0;
+            for (std::size_t p = 0; p < pixels; p++)
+            {
+                differ += filtered.getData()[p] != previous.getData()[p];
+            }
+            for (std::size_t p : slider.changed())
+            {
+                same = same && filtered.getData()[p] != previous.getData()[p];
+            }
+            same = same && differ == slider.changed().size();
+        }
+        previous = filtered;
+
+        start = Clock::now();
+        FilterCriterion area = {FilterCriterion::Area, FilterCriterion::GreaterEqual, thresholds[i]};
+        GrainFilter<LibTIM::U8> filter(attributes, std::vector<FilterCriterion>(1, area));
+        filter.reconstruct(reference);
+        fulls.push_back(elapsed(start));
+
+        same = same && std::equal(filtered.getData(), filtered.getData() + pixels, reference.getData());
+    }
+
+    std::sort(updates.begin(), updates.end());
+    std::sort(fulls.begin(), fulls.end());
+    std::cout << updates.size() << " slider updates: median " << updates[updates.size() / 2] << " ms, max " << updates.back()
+              << " ms, " << updatedPixels / thresholds.size() << " pixels changed on average" << std::endl
+              << "full filter and reconstruction: median " << fulls[fulls.size() / 2] << " ms" << std::endl
+              << "full pipeline: " << build + fulls[fulls.size() / 2] << " ms" << std::endl
+              << (same ? "images match" : "IMAGES DIFFER") << std::endl;
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,59 @@
+#ifndef ANCESTOR_INDEX_H
+#define ANCESTOR_INDEX_H
+
+#include "buffer_pool.h"
+#include "node_table.h"
+#include <cstddef>
+#include <cstdint>
+
+// Ancestor queries on the nodes of a tree of shapes, for the smallest shape containing two pixels.
+// The lowest common ancestor of two nodes u and v, u before v in preorder, is the parent of the
+// shallowest node at the positions (position(u), position(v)] of the preorder: a range minimum on
+// the depths, found in constant time with a sparse table over blocks of BLOCK positions and a scan
+// of the two blocks at the ends of the range. The sparse table has (n / BLOCK) log(n / BLOCK) entries.
+// "Constant" hides these scans: a query reads up to 2 * BLOCK depths, plus two table entries.
+// The ancestor of a node at a given depth is found by a binary search among the nodes of that depth.
+// "Is shape a inside shape b" is NodeTable::isAncestor(), in constant time.
+template <typename T>
+class AncestorIndex
+{
+public:
+    static const std::size_t BLOCK = 16;
+
+    explicit AncestorIndex(const NodeTable<T> &nodes);
+
+    inline const NodeTable<T> &nodes() const;
+
+    // smallest shape containing the shapes <a> and <b>, scanning up to 2 * BLOCK depths
+    inline NodeIndex lca(NodeIndex a, NodeIndex b) const;
+    // ancestor of <n> at depth <depth>, out_of_range if <depth> is larger than depth(n)
+    inline NodeIndex ancestor(NodeIndex n, std::size_t depth) const;
+    // smallest shape containing a pixel, given by its offset in the original image
+    inline NodeIndex pixelNode(std::size_t pixel) const;
+
+    // smallest shape containing the pixels first[i] and second[i] (offsets in the original image)
+    // in result[i], for i < count, in parallel
+    void lca(const std::size_t *first, const std::size_t *second, std::size_t count, NodeIndex *result) const;
+
+private:
+    // position of a shallowest node at the positions [begin, end]
+    inline std::size_t minPosition(std::size_t begin, std::size_t end) const;
+    // position of a shallowest node at the positions [begin, end], scanning them
+    inline std::size_t scan(std::size_t begin, std::size_t end) const;
+
+private:
+    const NodeTable<T> &m_nodes;
+    Buffer<std::uint32_t> m_depth; // depth of the node at each position in preorder
+
+    // m_table[k * m_blocks + b]: position of a shallowest node in the blocks [b, b + 2^k)
+    std::size_t m_blocks;
+    Buffer<NodeIndex> m_table;
+
+    // positions in preorder of the nodes of depth d: m_byDepth[m_depthBegin[d]] to m_byDepth[m_depthBegin[d + 1] - 1]
+    Buffer<std::size_t> m_depthBegin;
+    Buffer<std::size_t> m_byDepth;
+};
+
+#include "ancestor_index.hpp"
+
+#endif // ANCESTOR_INDEX_H
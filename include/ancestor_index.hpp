@@ -0,0 +1,162 @@
+#include "ancestor_index.h"
+#include "profiler.h"
+#include <algorithm>
+#include <stdexcept>
+
+template <typename T>
+const std::size_t AncestorIndex<T>::BLOCK;
+
+template <typename T>
+AncestorIndex<T>::AncestorIndex(const NodeTable<T> &nodes) : m_nodes(nodes)
+{
+    Profiler::Scope stage("ancestorIndex");
+    std::size_t count = nodes.size();
+    stage.items(count);
+
+    std::size_t maxDepth = 0;
+    m_depth.resize(count);
+    for (std::size_t p = 0; p < count; p++)
+    {
+        m_depth[p] = static_cast<std::uint32_t>(nodes.depth(nodes.preorder(p)));
+        maxDepth = std::max<std::size_t>(maxDepth, m_depth[p]);
+    }
+
+    // sparse table over the blocks, level k from level k - 1
+    m_blocks = (count + BLOCK - 1) / BLOCK;
+    std::size_t levels = 1;
+    while ((std::size_t(1) << levels) <= m_blocks)
+    {
+        levels++;
+    }
+    m_table.resize(levels * m_blocks);
+    for (std::size_t b = 0; b < m_blocks; b++)
+    {
+        m_table[b] = static_cast<NodeIndex>(scan(b * BLOCK, std::min(count, (b + 1) * BLOCK) - 1));
+    }
+    for (std::size_t k = 1; k < levels; k++)
+    {
+        const NodeIndex *previous = &m_table[(k - 1) * m_blocks];
+        NodeIndex *level = &m_table[k * m_blocks];
+        std::size_t half = std::size_t(1) << (k - 1);
+        for (std::size_t b = 0; b + 2 * half <= m_blocks; b++)
+        {
+            NodeIndex left = previous[b], right = previous[b + half];
+            level[b] = m_depth[right] < m_depth[left] ? right : left;
+        }
+    }
+
+    // nodes by depth with a counting sort, in preorder within each depth
+    m_depthBegin.assign(maxDepth + 2, 0);
+    for (std::size_t p = 0; p < count; p++)
+    {
+        m_depthBegin[m_depth[p] + 1]++;
+    }
+    for (std::size_t d = 1; d < m_depthBegin.size(); d++)
+    {
+        m_depthBegin[d] += m_depthBegin[d - 1];
+    }
+    m_byDepth.resize(count);
+    Buffer<std::size_t> next(m_depthBegin.begin(), m_depthBegin.end() - 1);
+    for (std::size_t p = 0; p < count; p++)
+    {
+        m_byDepth[next[m_depth[p]]++] = p;
+    }
+}
+
+template <typename T>
+const NodeTable<T> &AncestorIndex<T>::nodes() const { return m_nodes; }
+
+template <typename T>
+NodeIndex AncestorIndex<T>::lca(NodeIndex a, NodeIndex b) const
+{
+    if (a == b)
+    {
+        return a;
+    }
+    std::size_t pa = m_nodes.position(a), pb = m_nodes.position(b);
+    if (pa > pb)
+    {
+        std::swap(pa, pb);
+    }
+    // the shallowest node after a up to b is a child of the lca on the path to b
+    return m_nodes.parent(m_nodes.preorder(minPosition(pa + 1, pb)));
+}
+
+template <typename T>
+NodeIndex AncestorIndex<T>::ancestor(NodeIndex n, std::size_t depth) const
+{
+    if (depth > m_depth[m_nodes.position(n)])
+    {
+        throw std::out_of_range("AncestorIndex::ancestor: depth larger than the depth of the node");
+    }
+    // the ancestor is the last node of that depth before n in preorder
+    const std::size_t *first = m_byDepth.data() + m_depthBegin[depth];
+    const std::size_t *last = m_byDepth.data() + m_depthBegin[depth + 1];
+    return m_nodes.preorder(*(std::upper_bound(first, last, m_nodes.position(n)) - 1));
+}
+
+template <typename T>
+NodeIndex AncestorIndex<T>::pixelNode(std::size_t pixel) const
+{
+    std::size_t y = pixel / m_nodes.pixelWidth();
+    return m_nodes.node(m_nodes.pixelFace(pixel - y * m_nodes.pixelWidth(), y));
+}
+
+template <typename T>
+void AncestorIndex<T>::lca(const std::size_t *first, const std::size_t *second, std::size_t count, NodeIndex *result) const
+{
+    Profiler::Scope stage("lca");
+    stage.items(count);
+#pragma omp parallel for schedule(static)
+    for (std::size_t i = 0; i < count; i++)
+    {
+        result[i] = lca(pixelNode(first[i]), pixelNode(second[i]));
+    }
+}
+
+template <typename T>
+std::size_t AncestorIndex<T>::minPosition(std::size_t begin, std::size_t end) const
+{
+    std::size_t first = begin / BLOCK, last = end / BLOCK;
+    if (first == last)
+    {
+        return scan(begin, end);
+    }
+    std::size_t best = scan(begin, (first + 1) * BLOCK - 1);
+    std::size_t tail = scan(last * BLOCK, end);
+    if (m_depth[tail] < m_depth[best])
+    {
+        best = tail;
+    }
+    if (first + 1 < last)
+    {
+        // two overlapping power of two ranges cover the whole blocks in between
+        std::size_t blocks = last - first - 1;
+        std::size_t k = 63 - __builtin_clzll(static_cast<unsigned long long>(blocks));
+        std::size_t left = m_table[k * m_blocks + first + 1];
+        std::size_t right = m_table[k * m_blocks + last - (std::size_t(1) << k)];
+        if (m_depth[left] < m_depth[best])
+        {
+            best = left;
+        }
+        if (m_depth[right] < m_depth[best])
+        {
+            best = right;
+        }
+    }
+    return best;
+}
+
+template <typename T>
+std::size_t AncestorIndex<T>::scan(std::size_t begin, std::size_t end) const
+{
+    std::size_t best = begin;
+    for (std::size_t p = begin + 1; p <= end; p++)
+    {
+        if (m_depth[p] < m_depth[best])
+        {
+            best = p;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,58 @@
+#ifndef ATTRIBUTES_H
+#define ATTRIBUTES_H
+
+#include "buffer_pool.h"
+#include "node_table.h"
+#include "svm_cell.h"
+#include <cstddef>
+#include <cstdint>
+
+// Attributes of the nodes of a tree of shapes, accumulated without recursion in one pass over the
+// faces children first, that adds each pixel to its node and each node to its parent.
+// The pixels are the Original cells of the original image (not its median border), with the
+// coordinates of the original image.
+// On the interpolated tree, a node made of interpolated faces only has no pixels.
+// The contour length is the number of interpixel faces (Inter2 cells) on the boundary of the
+// shape, about two per pixel side: it needs the faces of the interpolated grid, so it is only
+// computed on a tree that is not uninterpolated yet (0 otherwise).
+template <typename T>
+class Attributes
+{
+public:
+    struct Box
+    {
+        std::size_t xMin, yMin, xMax, yMax; // inclusive, xMin > xMax for a node without pixels
+    };
+
+    explicit Attributes(const NodeTable<T> &nodes);
+
+    inline const NodeTable<T> &nodes() const;
+    inline bool hasContour() const;
+
+    inline std::size_t area(NodeIndex n) const;  // number of pixels of the shape
+    inline const Box &box(NodeIndex n) const;
+    inline double sum(NodeIndex n) const;        // sum of the pixel values
+    inline double sumSquares(NodeIndex n) const;
+    inline double mean(NodeIndex n) const;
+    inline double variance(NodeIndex n) const;
+    // raw moment sum(x^p y^q) over the pixels, for p + q <= 2
+    inline double moment(NodeIndex n, unsigned int p, unsigned int q) const;
+    // normalized moment of inertia (mu20 + mu02) / area^2
+    inline double inertia(NodeIndex n) const;
+    inline std::int64_t contourLength(NodeIndex n) const;
+
+private:
+    const NodeTable<T> &m_nodes;
+    bool m_contour;
+
+    // indexed by node
+    Buffer<std::size_t> m_area;
+    Buffer<Box> m_box;
+    Buffer<double> m_sum, m_sum2;
+    Buffer<double> m_m10, m_m01, m_m20, m_m02, m_m11;
+    Buffer<std::int64_t> m_contourLength;
+};
+
+#include "attributes.hpp"
+
+#endif // ATTRIBUTES_H
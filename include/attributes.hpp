@@ -0,0 +1,178 @@
+#include "attributes.h"
+#include "profiler.h"
+#include <algorithm>
+
+template <typename T>
+Attributes<T>::Attributes(const NodeTable<T> &nodes) : m_nodes(nodes), m_contour(nodes.tree().image().interpolated())
+{
+    Profiler::Scope stage("attributes");
+    const TOS<T> &tree = nodes.tree();
+    const SVMImage<T> &image = tree.image();
+    const Buffer<FaceIndex> &order = tree.order();
+    stage.items(order.size());
+
+    std::size_t count = nodes.size();
+
+    m_area.assign(count, 0);
+    Box empty = {static_cast<std::size_t>(-1), static_cast<std::size_t>(-1), 0, 0};
+    m_box.assign(count, empty);
+    m_sum.assign(count, 0);
+    m_sum2.assign(count, 0);
+    m_m10.assign(count, 0);
+    m_m01.assign(count, 0);
+    m_m20.assign(count, 0);
+    m_m02.assign(count, 0);
+    m_m11.assign(count, 0);
+    m_contourLength.assign(count, 0);
+
+    // the pixels are every 4 cells of the interpolated grid, or every cell once uninterpolated;
+    // the first and last ones of each row and column are the median border
+    std::size_t width = image.width(), height = image.height();
+    std::size_t step = m_contour ? 4 : 1;
+    std::size_t pixelWidth = (width + step - 1) / step - 2;
+    std::size_t pixelHeight = (height + step - 1) / step - 2;
+
+    // faces already accumulated, for the contours
+    Buffer<unsigned char> visited(m_contour ? order.size() : 0, 0);
+
+    for (std::size_t i = order.size(); i-- > 0;)
+    {
+        FaceIndex f = order[i];
+        NodeIndex n = nodes.node(f);
+        std::size_t x = image.posX(f), y = image.posY(f);
+
+        if (x % step == 0 && y % step == 0 && x / step - 1 < pixelWidth && y / step - 1 < pixelHeight)
+        {
+            // x / step - 1 wraps around on the left and top borders
+            std::size_t px = x / step - 1, py = y / step - 1;
+            double v = static_cast<double>(image.levelValue(tree.level(f)));
+            m_area[n]++;
+            m_sum[n] += v;
+            m_sum2[n] += v * v;
+            m_m10[n] += px;
+            m_m01[n] += py;
+            m_m20[n] += static_cast<double>(px) * px;
+            m_m02[n] += static_cast<double>(py) * py;
+            m_m11[n] += static_cast<double>(px) * py;
+            Box &b = m_box[n];
+            b.xMin = std::min(b.xMin, px);
+            b.yMin = std::min(b.yMin, py);
+            b.xMax = std::max(b.xMax, px);
+            b.yMax = std::max(b.yMax, py);
+        }
+
+        if (m_contour)
+        {
+            // the faces visited before f are in its subtree (that is how the union-find builds the
+            // tree): an interpixel face e of an Original or New cell f that is not visited yet is in
+            // an ancestor node of f, so it is on the boundary of the shapes between node(f) and node(e)
+            if (x % 2 == 0 && y % 2 == 0)
+            {
+                FaceIndex neighbours[4];
+                unsigned int k = 0;
+                if (x > 0)
+                    neighbours[k++] = f - 1;
+                if (x + 1 < width)
+                    neighbours[k++] = f + 1;
+                if (y > 0)
+                    neighbours[k++] = f - width;
+                if (y + 1 < height)
+                    neighbours[k++] = f + width;
+                for (unsigned int j = 0; j < k; j++)
+                {
+                    if (!visited[neighbours[j]])
+                    {
+                        m_contourLength[n]++;
+                        m_contourLength[nodes.node(neighbours[j])]--;
+                    }
+                }
+            }
+            visited[f] = 1;
+        }
+
+        // the canonical face is the last one of its node: the node is complete
+        NodeIndex p = nodes.parent(n);
+        if (nodes.face(n) == f && p != n)
+        {
+            m_area[p] += m_area[n];
+            m_sum[p] += m_sum[n];
+            m_sum2[p] += m_sum2[n];
+            m_m10[p] += m_m10[n];
+            m_m01[p] += m_m01[n];
+            m_m20[p] += m_m20[n];
+            m_m02[p] += m_m02[n];
+            m_m11[p] += m_m11[n];
+            m_contourLength[p] += m_contourLength[n];
+            Box &b = m_box[p];
+            const Box &c = m_box[n];
+            b.xMin = std::min(b.xMin, c.xMin);
+            b.yMin = std::min(b.yMin, c.yMin);
+            b.xMax = std::max(b.xMax, c.xMax);
+            b.yMax = std::max(b.yMax, c.yMax);
+        }
+    }
+}
+
+template <typename T>
+const NodeTable<T> &Attributes<T>::nodes() const { return m_nodes; }
+template <typename T>
+bool Attributes<T>::hasContour() const { return m_contour; }
+
+template <typename T>
+std::size_t Attributes<T>::area(NodeIndex n) const { return m_area[n]; }
+template <typename T>
+const typename Attributes<T>::Box &Attributes<T>::box(NodeIndex n) const { return m_box[n]; }
+template <typename T>
+double Attributes<T>::sum(NodeIndex n) const { return m_sum[n]; }
+template <typename T>
+double Attributes<T>::sumSquares(NodeIndex n) const { return m_sum2[n]; }
+template <typename T>
+double Attributes<T>::mean(NodeIndex n) const { return m_area[n] ? m_sum[n] / m_area[n] : 0; }
+template <typename T>
+double Attributes<T>::variance(NodeIndex n) const
+{
+    if (!m_area[n])
+    {
+        return 0;
+    }
+    double mean = m_sum[n] / m_area[n];
+    return std::max(0.0, m_sum2[n] / m_area[n] - mean * mean);
+}
+
+template <typename T>
+double Attributes<T>::moment(NodeIndex n, unsigned int p, unsigned int q) const
+{
+    switch (p * 3 + q)
+    {
+    case 0:
+        return static_cast<double>(m_area[n]);
+    case 1:
+        return m_m01[n];
+    case 2:
+        return m_m02[n];
+    case 3:
+        return m_m10[n];
+    case 4:
+        return m_m11[n];
+    case 6:
+        return m_m20[n];
+    default:
+        return 0; // order above 2
+    }
+}
+
+template <typename T>
+double Attributes<T>::inertia(NodeIndex n) const
+{
+    if (!m_area[n])
+    {
+        return 0;
+    }
+    double area = static_cast<double>(m_area[n]);
+    double mu20 = m_m20[n] - m_m10[n] * m_m10[n] / area;
+    double mu02 = m_m02[n] - m_m01[n] * m_m01[n] / area;
+    return (mu20 + mu02) / (area * area);
+}
+
+template <typename T>
+std::int64_t Attributes<T>::contourLength(NodeIndex n) const { return m_contourLength[n]; }
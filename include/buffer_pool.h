@@ -0,0 +1,74 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Pool of large memory blocks shared by the flat arrays of SVMImage and TOS.
+// A released block is kept for the next array of similar size (at most MAX_REUSE_RATIO times larger)
+// instead of going back to the system, so that processing a sequence of images of similar sizes only
+// allocates when an image is larger than the previous ones; release() frees all the kept blocks at once.
+class BufferPool
+{
+public:
+    // blocks smaller than this are not pooled
+    static const std::size_t MIN_POOLED_BYTES = 64 * 1024;
+    // a free block is reused for a request of at least 1 / MAX_REUSE_RATIO of its size
+    static const std::size_t MAX_REUSE_RATIO = 2;
+
+    static BufferPool &instance();
+
+    void *allocate(std::size_t bytes);
+    void deallocate(void *block, std::size_t bytes);
+
+    // free the blocks kept for reuse
+    void release();
+    // bytes kept for reuse
+    std::size_t kept() const;
+
+    // number of allocations and bytes requested since the start, pooled or not
+    inline std::size_t allocations() const;
+    inline std::size_t allocatedBytes() const;
+
+private:
+    BufferPool() : m_kept(0), m_allocations(0), m_allocatedBytes(0) {}
+    ~BufferPool();
+
+    mutable std::mutex m_mutex;
+    std::multimap<std::size_t, void *> m_free; // free blocks by size
+    std::map<void *, std::size_t> m_used;      // size of the blocks in use
+    std::size_t m_kept;
+    std::atomic<std::size_t> m_allocations;
+    std::atomic<std::size_t> m_allocatedBytes;
+};
+
+// Standard allocator taking its blocks from the BufferPool
+template <typename T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+
+    PoolAllocator() {}
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &) {}
+
+    T *allocate(std::size_t n);
+    void deallocate(T *p, std::size_t n);
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U> &) const { return false; }
+};
+
+// flat array whose memory comes from the BufferPool
+template <typename T>
+using Buffer = std::vector<T, PoolAllocator<T>>;
+
+#include "buffer_pool.hpp"
+
+#endif // BUFFER_POOL_H
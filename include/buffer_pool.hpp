@@ -0,0 +1,87 @@
+#include "buffer_pool.h"
+#include <new>
+
+inline BufferPool &BufferPool::instance()
+{
+    static BufferPool pool;
+    return pool;
+}
+
+inline BufferPool::~BufferPool()
+{
+    release();
+}
+
+inline void *BufferPool::allocate(std::size_t bytes)
+{
+    m_allocations++;
+    m_allocatedBytes += bytes;
+    if (bytes < MIN_POOLED_BYTES)
+    {
+        return ::operator new(bytes);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // smallest free block large enough, and not much larger: a small array must not pin the block of
+    // a large image, which would make the next large image allocate a new one
+    auto it = m_free.lower_bound(bytes);
+    if (it != m_free.end() && it->first / MAX_REUSE_RATIO <= bytes)
+    {
+        void *block = it->second;
+        m_used[block] = it->first;
+        m_kept -= it->first;
+        m_free.erase(it);
+        return block;
+    }
+    void *block = ::operator new(bytes);
+    m_used[block] = bytes;
+    return block;
+}
+
+inline void BufferPool::deallocate(void *block, std::size_t bytes)
+{
+    if (bytes < MIN_POOLED_BYTES)
+    {
+        ::operator delete(block);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_used.find(block);
+    std::size_t size = it->second;
+    m_used.erase(it);
+    m_free.insert(std::make_pair(size, block));
+    m_kept += size;
+}
+
+inline void BufferPool::release()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &block : m_free)
+    {
+        ::operator delete(block.second);
+    }
+    m_free.clear();
+    m_kept = 0;
+}
+
+inline std::size_t BufferPool::kept() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_kept;
+}
+
+std::size_t BufferPool::allocations() const { return m_allocations; }
+std::size_t BufferPool::allocatedBytes() const { return m_allocatedBytes; }
+
+template <typename T>
+T *PoolAllocator<T>::allocate(std::size_t n)
+{
+    return static_cast<T *>(BufferPool::instance().allocate(n * sizeof(T)));
+}
+
+template <typename T>
+void PoolAllocator<T>::deallocate(T *p, std::size_t n)
+{
+    BufferPool::instance().deallocate(p, n * sizeof(T));
+}
@@ -0,0 +1,119 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "attributes.h"
+#include "buffer_pool.h"
+#include "node_table.h"
+#include <Common/Image.h>
+#include <vector>
+
+// Criterion on an attribute of the nodes, written <attribute><comparison><threshold>, as "area>=100"
+struct FilterCriterion
+{
+    enum Attribute
+    {
+        Area,     // number of pixels
+        Contrast, // level difference with the parent node
+        Contour,  // contour length, needs the interpolated tree
+        Inertia,  // normalized moment of inertia, low for compact shapes
+        Mean,     // mean pixel value
+        Variance, // variance of the pixel values
+        Depth     // number of ancestors
+    };
+    enum Comparison
+    {
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual
+    };
+
+    Attribute attribute;
+    Comparison comparison;
+    double threshold;
+
+    inline bool accept(double value) const;
+};
+
+// parse a comma separated list of criteria, as "area>=100,contrast>10", false on syntax error
+inline bool parseFilter(const char *text, std::vector<FilterCriterion> &criteria);
+// true if one of the criteria is on the contour length
+inline bool needsContour(const std::vector<FilterCriterion> &criteria);
+
+// Grain filter on the tree of shapes: the nodes that do not satisfy all the criteria are removed,
+// their pixels taking the level of the closest kept ancestor (the root is always kept). The tree
+// being self-dual, bright and dark grains are filtered alike, in a single tree.
+template <typename T>
+class GrainFilter
+{
+public:
+    GrainFilter(const Attributes<T> &attributes, const std::vector<FilterCriterion> &criteria);
+
+    inline bool kept(NodeIndex n) const;
+    inline std::size_t keptCount() const;
+    // level of the pixels of <n> in the filtered image
+    inline T level(NodeIndex n) const;
+
+    // filtered image, with the size of the original image, in one pass over the pixels
+    void reconstruct(LibTIM::Image<T> &im) const;
+
+    static double attribute(const Attributes<T> &attributes, NodeIndex n, FilterCriterion::Attribute attribute);
+
+private:
+    const NodeTable<T> &m_nodes;
+    Buffer<unsigned char> m_kept;
+    Buffer<T> m_level;
+    std::size_t m_keptCount;
+};
+
+// Grain filter on one attribute kept resident for interactive thresholds, as a slider: the nodes
+// are sorted by attribute and the pixels grouped by subtree (nodes in preorder), so that a new
+// threshold only updates the nodes crossing it and the pixels of their subtrees.
+// The nodes whose attribute is >= threshold are kept.
+template <typename T>
+class IncrementalFilter
+{
+public:
+    IncrementalFilter(const Attributes<T> &attributes, FilterCriterion::Attribute attribute);
+
+    // filter with <threshold>, updating the filtered image <im> (fully rendered on the first call),
+    // and return the number of pixels whose value changed
+    std::size_t setThreshold(double threshold, LibTIM::Image<T> &im);
+
+    inline double threshold() const;
+    inline std::size_t keptCount() const;
+    // offsets in the image of the pixels whose value changed with the last setThreshold()
+    // (all of them on the first call)
+    inline const Buffer<std::size_t> &changed() const;
+
+private:
+    // recompute the levels of the nodes in preorder [<begin>, <end>) and write the pixels of the nodes
+    // whose level changed, or of all of them with <all>
+    void render(std::size_t begin, std::size_t end, T *out, bool all);
+
+private:
+    const NodeTable<T> &m_nodes;
+    std::size_t m_width, m_height;
+
+    // nodes other than the root by increasing attribute: m_sorted[0, m_removed) are removed
+    Buffer<NodeIndex> m_sorted;
+    Buffer<double> m_values;
+    std::size_t m_removed;
+    double m_threshold;
+    bool m_rendered;
+
+    // indexed by node
+    Buffer<unsigned char> m_kept;
+    Buffer<T> m_level;
+
+    // indexed by position in preorder (see NodeTable):
+    // pixels of the node at position p: m_pixels[m_pixelBegin[p]] to m_pixels[m_pixelBegin[p + 1] - 1]
+    Buffer<std::size_t> m_pixelBegin;
+    Buffer<std::size_t> m_pixels;
+
+    Buffer<std::size_t> m_changed;
+};
+
+#include "filter.hpp"
+
+#endif // FILTER_H
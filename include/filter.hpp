@@ -0,0 +1,295 @@
+#include "filter.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+inline bool FilterCriterion::accept(double value) const
+{
+    switch (comparison)
+    {
+    case Less:
+        return value < threshold;
+    case LessEqual:
+        return value <= threshold;
+    case Greater:
+        return value > threshold;
+    default:
+        return value >= threshold;
+    }
+}
+
+inline bool parseFilter(const char *text, std::vector<FilterCriterion> &criteria)
+{
+    static const char *NAMES[] = {"area", "contrast", "contour", "inertia", "mean", "variance", "depth"};
+
+    criteria.clear();
+    const char *p = text;
+    while (*p)
+    {
+        FilterCriterion criterion;
+        std::size_t length = std::strcspn(p, "<>");
+        int i = 0;
+        while (i < 7 && (std::strlen(NAMES[i]) != length || std::strncmp(p, NAMES[i], length) != 0))
+        {
+            i++;
+        }
+        if (i == 7)
+        {
+            return false;
+        }
+        criterion.attribute = static_cast<FilterCriterion::Attribute>(i);
+        p += length;
+
+        bool less = *p == '<';
+        if (*p != '<' && *p != '>')
+        {
+            return false;
+        }
+        p++;
+        bool equal = *p == '=';
+        p += equal;
+        criterion.comparison = less ? (equal ? FilterCriterion::LessEqual : FilterCriterion::Less)
+                                    : (equal ? FilterCriterion::GreaterEqual : FilterCriterion::Greater);
+
+        char *end;
+        criterion.threshold = std::strtod(p, &end);
+        if (end == p || (*end != ',' && *end != '\0'))
+        {
+            return false;
+        }
+        p = *end ? end + 1 : end;
+        criteria.push_back(criterion);
+    }
+    return !criteria.empty();
+}
+
+inline bool needsContour(const std::vector<FilterCriterion> &criteria)
+{
+    for (const FilterCriterion &c : criteria)
+    {
+        if (c.attribute == FilterCriterion::Contour)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T>
+GrainFilter<T>::GrainFilter(const Attributes<T> &attributes, const std::vector<FilterCriterion> &criteria)
+    : m_nodes(attributes.nodes()), m_keptCount(0)
+{
+    Profiler::Scope stage("filter");
+    std::size_t count = m_nodes.size();
+    stage.items(count);
+
+    m_kept.resize(count);
+    m_level.resize(count);
+    // parents first: the level of a removed node is already known for its parent
+    for (NodeIndex n = 0; n < count; n++)
+    {
+        bool keep = n == 0;
+        if (!keep)
+        {
+            keep = true;
+            for (const FilterCriterion &c : criteria)
+            {
+                if (!c.accept(attribute(attributes, n, c.attribute)))
+                {
+                    keep = false;
+                    break;
+                }
+            }
+        }
+        m_kept[n] = keep;
+        m_level[n] = keep ? m_nodes.level(n) : m_level[m_nodes.parent(n)];
+        m_keptCount += keep;
+    }
+}
+
+template <typename T>
+bool GrainFilter<T>::kept(NodeIndex n) const { return m_kept[n]; }
+template <typename T>
+std::size_t GrainFilter<T>::keptCount() const { return m_keptCount; }
+template <typename T>
+T GrainFilter<T>::level(NodeIndex n) const { return m_level[n]; }
+
+template <typename T>
+void GrainFilter<T>::reconstruct(LibTIM::Image<T> &im) const
+{
+    Profiler::Scope stage("reconstruct");
+    std::size_t step = m_nodes.tree().image().interpolated() ? 4 : 1;
+    std::size_t width = m_nodes.pixelWidth();
+    std::size_t height = m_nodes.pixelHeight();
+    stage.items(width * height);
+
+    im.setSize(static_cast<LibTIM::TSize>(width), static_cast<LibTIM::TSize>(height), 1);
+    T *out = im.getData();
+    for (std::size_t y = 0; y < height; y++)
+    {
+        FaceIndex face = m_nodes.pixelFace(0, y);
+        for (std::size_t x = 0; x < width; x++, face += step)
+        {
+            *out++ = m_level[m_nodes.node(face)];
+        }
+    }
+}
+
+template <typename T>
+double GrainFilter<T>::attribute(const Attributes<T> &attributes, NodeIndex n, FilterCriterion::Attribute attribute)
+{
+    const NodeTable<T> &nodes = attributes.nodes();
+    switch (attribute)
+    {
+    case FilterCriterion::Area:
+        return static_cast<double>(attributes.area(n));
+    case FilterCriterion::Contrast:
+        return std::fabs(static_cast<double>(nodes.level(n)) - static_cast<double>(nodes.level(nodes.parent(n))));
+    case FilterCriterion::Contour:
+        return static_cast<double>(attributes.contourLength(n));
+    case FilterCriterion::Inertia:
+        return attributes.inertia(n);
+    case FilterCriterion::Mean:
+        return attributes.mean(n);
+    case FilterCriterion::Variance:
+        return attributes.variance(n);
+    default:
+        return static_cast<double>(nodes.depth(n));
+    }
+}
+
+template <typename T>
+IncrementalFilter<T>::IncrementalFilter(const Attributes<T> &attributes, FilterCriterion::Attribute attribute)
+    : m_nodes(attributes.nodes()), m_removed(0), m_threshold(0), m_rendered(false)
+{
+    Profiler::Scope stage("incrementalFilter");
+    const SVMImage<T> &image = m_nodes.tree().image();
+    std::size_t count = m_nodes.size();
+    stage.items(count);
+
+    m_sorted.resize(count - 1);
+    for (NodeIndex n = 1; n < count; n++)
+    {
+        m_sorted[n - 1] = n;
+    }
+    Buffer<double> value(count);
+    for (NodeIndex n = 0; n < count; n++)
+    {
+        value[n] = GrainFilter<T>::attribute(attributes, n, attribute);
+    }
+    std::sort(m_sorted.begin(), m_sorted.end(), [&value](NodeIndex a, NodeIndex b) { return value[a] < value[b]; });
+    m_values.resize(count - 1);
+    for (std::size_t i = 0; i < m_sorted.size(); i++)
+    {
+        m_values[i] = value[m_sorted[i]];
+    }
+
+    // pixels by counting sort on the preorder position of their node
+    std::size_t step = image.interpolated() ? 4 : 1;
+    m_width = m_nodes.pixelWidth();
+    m_height = m_nodes.pixelHeight();
+    Buffer<std::size_t> pixelPosition(m_width * m_height);
+    m_pixelBegin.assign(count + 1, 0);
+    for (std::size_t y = 0, i = 0; y < m_height; y++)
+    {
+        FaceIndex face = m_nodes.pixelFace(0, y);
+        for (std::size_t x = 0; x < m_width; x++, face += step, i++)
+        {
+            pixelPosition[i] = m_nodes.position(m_nodes.node(face));
+            m_pixelBegin[pixelPosition[i] + 1]++;
+        }
+    }
+    for (std::size_t p = 1; p <= count; p++)
+    {
+        m_pixelBegin[p] += m_pixelBegin[p - 1];
+    }
+    m_pixels.resize(pixelPosition.size());
+    Buffer<std::size_t> next(m_pixelBegin.begin(), m_pixelBegin.end() - 1);
+    for (std::size_t i = 0; i < pixelPosition.size(); i++)
+    {
+        m_pixels[next[pixelPosition[i]]++] = i;
+    }
+
+    m_kept.assign(count, 1);
+    m_level.resize(count);
+}
+
+template <typename T>
+std::size_t IncrementalFilter<T>::setThreshold(double threshold, LibTIM::Image<T> &im)
+{
+    Profiler::Scope stage("refilter");
+    m_threshold = threshold;
+    m_changed.clear();
+
+    std::size_t removed = std::lower_bound(m_values.begin(), m_values.end(), threshold) - m_values.begin();
+    if (!m_rendered)
+    {
+        for (std::size_t i = 0; i < m_sorted.size(); i++)
+        {
+            m_kept[m_sorted[i]] = i >= removed;
+        }
+        m_removed = removed;
+        im.setSize(static_cast<LibTIM::TSize>(m_width), static_cast<LibTIM::TSize>(m_height), 1);
+        render(0, m_nodes.size(), im.getData(), true);
+        m_rendered = true;
+        stage.items(m_changed.size());
+        return m_changed.size();
+    }
+
+    // nodes crossing the threshold, by preorder position
+    std::size_t first = std::min(removed, m_removed), last = std::max(removed, m_removed);
+    Buffer<std::size_t> toggled;
+    toggled.reserve(last - first);
+    for (std::size_t i = first; i < last; i++)
+    {
+        NodeIndex n = m_sorted[i];
+        m_kept[n] = i >= removed;
+        toggled.push_back(m_nodes.position(n));
+    }
+    m_removed = removed;
+    std::sort(toggled.begin(), toggled.end());
+
+    // the subtrees of the toggled nodes, each one once
+    std::size_t end = 0;
+    for (std::size_t p : toggled)
+    {
+        if (p >= end)
+        {
+            end = p + m_nodes.subtreeSize(m_nodes.preorder(p));
+            render(p, end, im.getData(), false);
+        }
+    }
+    stage.items(m_changed.size());
+    return m_changed.size();
+}
+
+template <typename T>
+void IncrementalFilter<T>::render(std::size_t begin, std::size_t end, T *out, bool all)
+{
+    for (std::size_t p = begin; p < end; p++)
+    {
+        NodeIndex n = m_nodes.preorder(p);
+        // the parent comes first in preorder, or is outside the subtree and up to date
+        T level = m_kept[n] ? m_nodes.level(n) : m_level[m_nodes.parent(n)];
+        // the pixels of a node all have its level: they change together, or not at all
+        if (!all && level == m_level[n])
+        {
+            continue;
+        }
+        m_level[n] = level;
+        for (std::size_t i = m_pixelBegin[p]; i < m_pixelBegin[p + 1]; i++)
+        {
+            out[m_pixels[i]] = level;
+        }
+        m_changed.insert(m_changed.end(), m_pixels.begin() + m_pixelBegin[p], m_pixels.begin() + m_pixelBegin[p + 1]);
+    }
+}
+
+template <typename T>
+double IncrementalFilter<T>::threshold() const { return m_threshold; }
+template <typename T>
+std::size_t IncrementalFilter<T>::keptCount() const { return m_nodes.size() - m_removed; }
+template <typename T>
+const Buffer<std::size_t> &IncrementalFilter<T>::changed() const { return m_changed; }
@@ -1,9 +1,21 @@
 #ifndef IMG_HANDLER_H
 #define IMG_HANDLER_H
 
+#include "buffer_pool.h"
 #include "svm_img.h"
+#include <Common/Image.h>
 #include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <vector>
 
+// Display of a SVMImage, cut in square tiles generated and uploaded only when they intersect the
+// view. Zoomed out views use a coarser level of a mipmap pyramid, where a texel covers 2^level cells
+// on each axis, so that about one texel is drawn per screen pixel whatever the zoom. A texel of level
+// k is the mean of the 2x2 texels below it at level k - 1, so a coarse tile is built from the four
+// tiles of the level below, not from the cells. The textures and the gray texels of the tiles are
+// kept in two caches of MAX_TILES tiles each, the least recently used ones being evicted first.
 template <typename T>
 class ImgHandler
 {
@@ -11,15 +23,51 @@ public:
     ImgHandler(SVMImage<T> &img);
 
     void draw(sf::RenderWindow &window);
+    // show the <pixels> (offsets) of <im>, an image of the size of the original image, each pixel on
+    // all the cells of its block when the image is interpolated
+    void update(const LibTIM::Image<T> &im, const Buffer<std::size_t> &pixels);
 
 private:
-    void feed();
+    static const std::size_t TILE = 256;      // size of a tile in texels
+    static const std::size_t MAX_TILES = 256; // textures kept in the cache
+
+    struct Tile
+    {
+        sf::Texture texture;
+        sf::Sprite sprite;
+        std::list<std::uint64_t>::iterator use; // position in m_lru
+    };
+
+    // gray levels of a tile, row major
+    struct Texels
+    {
+        std::vector<sf::Uint8> gray;
+        std::size_t width, height;
+        std::list<std::uint64_t>::iterator use; // position in m_texelLru
+    };
+
+    inline std::uint64_t key(unsigned int level, std::size_t tx, std::size_t ty) const;
+    // tile of the cache, generated if missing, and marked as the most recently used
+    Tile &tile(unsigned int level, std::size_t tx, std::size_t ty);
+    // texels of a tile, from the cells at level 0 and from the level below otherwise; the reference
+    // is valid until the next call
+    const Texels &texels(unsigned int level, std::size_t tx, std::size_t ty);
+    // gray level of the cell @ pos [x,y]
+    inline sf::Uint8 cellValue(std::size_t x, std::size_t y) const;
+
     SVMImage<T> &m_svmImage;
-    sf::Image m_image;
-    sf::Texture m_texture;
-    sf::Sprite m_sprite;
+    double m_scale;        // values wider than 8 bits are scaled down to [0, 255]
+    unsigned int m_levels; // the last level holds the whole image in one tile
+    // image shown on the pixels instead of the cell values, see update()
+    const LibTIM::Image<T> *m_filtered;
+
+    std::map<std::uint64_t, Tile> m_tiles;
+    std::list<std::uint64_t> m_lru; // keys of the tiles, most recently used first
+    std::map<std::uint64_t, Texels> m_texelCache;
+    std::list<std::uint64_t> m_texelLru;
+    std::vector<sf::Uint8> m_texels; // RGBA texels of the tile being generated
 };
 
 #include "img_handler.hpp"
 
-#endif
\ No newline at end of file
+#endif
@@ -1,40 +1,253 @@
 #include "img_handler.h"
+#include <algorithm>
+#include <cmath>
 
 template <typename T>
-ImgHandler<T>::ImgHandler(SVMImage<T> &img) : m_svmImage(img)
+const std::size_t ImgHandler<T>::TILE;
+template <typename T>
+const std::size_t ImgHandler<T>::MAX_TILES;
+
+template <typename T>
+ImgHandler<T>::ImgHandler(SVMImage<T> &img) : m_svmImage(img), m_filtered(nullptr)
 {
-    m_image.create(m_svmImage.width(), m_svmImage.height());
-    feed();
-    m_texture.loadFromImage(m_image);
-    m_sprite.setTexture(m_texture);
+    m_scale = m_svmImage.maxValue() > 255 ? 255.0 / m_svmImage.maxValue() : 1.0;
+    m_levels = 1;
+    while ((TILE << (m_levels - 1)) < std::max(m_svmImage.width(), m_svmImage.height()))
+    {
+        m_levels++;
+    }
+    m_texels.resize(TILE * TILE * 4);
 }
 
 template <typename T>
 void ImgHandler<T>::draw(sf::RenderWindow &window)
 {
-    window.draw(m_sprite);
+    const sf::View &view = window.getView();
+    sf::Vector2f center = view.getCenter(), size = view.getSize();
+
+    // about one texel per screen pixel
+    double cellsPerPixel = window.getSize().x ? std::fabs(size.x) / window.getSize().x : 1.0;
+    unsigned int level = 0;
+    while (level + 1 < m_levels && (std::size_t(2) << level) <= cellsPerPixel)
+    {
+        level++;
+    }
+
+    // tiles intersecting the view
+    double tileCells = static_cast<double>(TILE << level);
+    std::size_t tilesX = (m_svmImage.width() + (TILE << level) - 1) / (TILE << level);
+    std::size_t tilesY = (m_svmImage.height() + (TILE << level) - 1) / (TILE << level);
+    auto first = [tileCells](double pos) { return static_cast<std::size_t>(std::max(0.0, std::floor(pos / tileCells))); };
+    auto last = [tileCells](double pos, std::size_t tiles) {
+        return pos < 0 ? 0 : std::min(tiles, static_cast<std::size_t>(std::floor(pos / tileCells)) + 1);
+    };
+    std::size_t x0 = first(center.x - size.x / 2), x1 = last(center.x + size.x / 2, tilesX);
+    std::size_t y0 = first(center.y - size.y / 2), y1 = last(center.y + size.y / 2, tilesY);
+
+    std::size_t drawn = 0;
+    for (std::size_t ty = y0; ty < y1; ty++)
+    {
+        for (std::size_t tx = x0; tx < x1; tx++, drawn++)
+        {
+            window.draw(tile(level, tx, ty).sprite);
+        }
+    }
+
+    // the tiles of this frame are at the front of the list
+    while (m_tiles.size() > std::max(MAX_TILES, drawn))
+    {
+        m_tiles.erase(m_lru.back());
+        m_lru.pop_back();
+    }
 }
 
 template <typename T>
-void ImgHandler<T>::feed()
+void ImgHandler<T>::update(const LibTIM::Image<T> &im, const Buffer<std::size_t> &pixels)
 {
-    for (int j = 0; j < m_svmImage.height(); j++) //y
+    m_filtered = &im;
+
+    // a pixel is shown on its block of cells (see cellValue()), after the median border: drop the
+    // tiles holding them, they are generated again when drawn
+    std::size_t step = m_svmImage.interpolated() ? 4 : 1;
+    std::size_t width = im.getSizeX();
+    std::size_t lastX = m_svmImage.width() - 1, lastY = m_svmImage.height() - 1;
+    for (unsigned int level = 0; level < m_levels; level++)
     {
-        for (int i = 0; i < m_svmImage.width(); i++) //x
+        std::size_t tileCells = TILE << level;
+        std::size_t tilesX = (m_svmImage.width() + tileCells - 1) / tileCells;
+        std::size_t tilesY = (m_svmImage.height() + tileCells - 1) / tileCells;
+        std::vector<unsigned char> dirty(tilesX * tilesY, 0);
+        for (std::size_t i : pixels)
         {
-            SVMCell<T> *cell = m_svmImage.data().at(j * m_svmImage.width() + i);
-            if (cell->type() == CellType::Original || cell->type() == CellType::New)
+            std::size_t y = i / width, x = i - y * width;
+            // the block spans at most two tiles on each axis
+            std::size_t x0 = (x + 1) * step - step / 2, y0 = (y + 1) * step - step / 2;
+            std::size_t x1 = std::min(x0 + step - 1, lastX), y1 = std::min(y0 + step - 1, lastY);
+            dirty[(y0 / tileCells) * tilesX + x0 / tileCells] = 1;
+            dirty[(y0 / tileCells) * tilesX + x1 / tileCells] = 1;
+            dirty[(y1 / tileCells) * tilesX + x0 / tileCells] = 1;
+            dirty[(y1 / tileCells) * tilesX + x1 / tileCells] = 1;
+        }
+        for (std::size_t t = 0; t < dirty.size(); t++)
+        {
+            if (!dirty[t])
             {
-                sf::Uint8 val = static_cast<sf::Uint8>(cell->value());
-                sf::Color col(val, val, val);
-                m_image.setPixel(i, j, col);
+                continue;
             }
-            else
+            std::uint64_t k = key(level, t % tilesX, t / tilesX);
+            auto it = m_tiles.find(k);
+            if (it != m_tiles.end())
             {
-                sf::Uint8 val = static_cast<sf::Uint8>((cell->min() + cell->max()) / static_cast<T>(2));
-                sf::Color col(val, val, val);
-                m_image.setPixel(i, j, col);
+                m_lru.erase(it->second.use);
+                m_tiles.erase(it);
+            }
+            auto texels = m_texelCache.find(k);
+            if (texels != m_texelCache.end())
+            {
+                m_texelLru.erase(texels->second.use);
+                m_texelCache.erase(texels);
             }
         }
     }
 }
+
+template <typename T>
+std::uint64_t ImgHandler<T>::key(unsigned int level, std::size_t tx, std::size_t ty) const
+{
+    return (static_cast<std::uint64_t>(level) << 56) | (static_cast<std::uint64_t>(ty) << 28) | tx;
+}
+
+template <typename T>
+typename ImgHandler<T>::Tile &ImgHandler<T>::tile(unsigned int level, std::size_t tx, std::size_t ty)
+{
+    std::uint64_t k = key(level, tx, ty);
+    auto it = m_tiles.find(k);
+    if (it != m_tiles.end())
+    {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.use);
+        return it->second;
+    }
+
+    const Texels &gray = texels(level, tx, ty);
+    std::size_t width = gray.width, height = gray.height;
+    for (std::size_t i = 0; i < width * height; i++)
+    {
+        m_texels[4 * i] = m_texels[4 * i + 1] = m_texels[4 * i + 2] = gray.gray[i];
+        m_texels[4 * i + 3] = 255;
+    }
+    std::size_t span = std::size_t(1) << level;
+    std::size_t left = tx * (TILE << level), top = ty * (TILE << level);
+
+    Tile &t = m_tiles[k];
+    t.texture.create(static_cast<unsigned int>(width), static_cast<unsigned int>(height));
+    t.texture.update(m_texels.data(), static_cast<unsigned int>(width), static_cast<unsigned int>(height), 0, 0);
+    t.texture.setSmooth(level > 0);
+    t.sprite.setTexture(t.texture, true);
+    t.sprite.setPosition(static_cast<float>(left), static_cast<float>(top));
+    t.sprite.setScale(static_cast<float>(span), static_cast<float>(span));
+    m_lru.push_front(k);
+    t.use = m_lru.begin();
+    return t;
+}
+
+template <typename T>
+const typename ImgHandler<T>::Texels &ImgHandler<T>::texels(unsigned int level, std::size_t tx, std::size_t ty)
+{
+    std::uint64_t k = key(level, tx, ty);
+    auto it = m_texelCache.find(k);
+    if (it != m_texelCache.end())
+    {
+        m_texelLru.splice(m_texelLru.begin(), m_texelLru, it->second.use);
+        return it->second;
+    }
+
+    // level <level> has ceil(size / 2^level) texels on each axis
+    std::size_t span = std::size_t(1) << level;
+    Texels t;
+    t.width = std::min(TILE, (m_svmImage.width() + span - 1) / span - tx * TILE);
+    t.height = std::min(TILE, (m_svmImage.height() + span - 1) / span - ty * TILE);
+    t.gray.resize(t.width * t.height);
+    if (level == 0)
+    {
+        for (std::size_t j = 0; j < t.height; j++)
+        {
+            for (std::size_t i = 0; i < t.width; i++)
+            {
+                t.gray[j * t.width + i] = cellValue(tx * TILE + i, ty * TILE + j);
+            }
+        }
+    }
+    else
+    {
+        // mean of the 2x2 texels below, read from the (up to) four tiles of the level below covering
+        // this one; each child is consumed before the next call, which may evict it
+        std::vector<unsigned int> sum(t.gray.size(), 0);
+        std::vector<unsigned char> count(t.gray.size(), 0);
+        std::size_t childSpan = span / 2;
+        std::size_t childWidth = (m_svmImage.width() + childSpan - 1) / childSpan;
+        std::size_t childHeight = (m_svmImage.height() + childSpan - 1) / childSpan;
+        for (std::size_t dy = 0; dy < 2; dy++)
+        {
+            for (std::size_t dx = 0; dx < 2; dx++)
+            {
+                std::size_t cx = 2 * tx + dx, cy = 2 * ty + dy;
+                if (cx * TILE >= childWidth || cy * TILE >= childHeight)
+                {
+                    continue;
+                }
+                const Texels &child = texels(level - 1, cx, cy);
+                for (std::size_t j = 0; j < child.height; j++)
+                {
+                    std::size_t row = ((dy * TILE + j) / 2) * t.width + dx * TILE / 2;
+                    for (std::size_t i = 0; i < child.width; i++)
+                    {
+                        sum[row + i / 2] += child.gray[j * child.width + i];
+                        count[row + i / 2]++;
+                    }
+                }
+            }
+        }
+        for (std::size_t i = 0; i < t.gray.size(); i++)
+        {
+            t.gray[i] = static_cast<sf::Uint8>((sum[i] + count[i] / 2) / count[i]);
+        }
+    }
+
+    // evicted before the insertion, so that the returned tile stays in the cache
+    while (m_texelCache.size() >= MAX_TILES)
+    {
+        m_texelCache.erase(m_texelLru.back());
+        m_texelLru.pop_back();
+    }
+    Texels &inserted = m_texelCache[k];
+    inserted.gray.swap(t.gray);
+    inserted.width = t.width;
+    inserted.height = t.height;
+    m_texelLru.push_front(k);
+    inserted.use = m_texelLru.begin();
+    return inserted;
+}
+
+template <typename T>
+sf::Uint8 ImgHandler<T>::cellValue(std::size_t x, std::size_t y) const
+{
+    if (m_filtered)
+    {
+        // on the interpolated grid, the New and Inter cells take the value of the closest Original
+        // cell: a pixel is shown on the cells [-2, +1] around its Original cell on each axis
+        std::size_t step = m_svmImage.interpolated() ? 4 : 1;
+        std::size_t px = (x + step / 2) / step - 1, py = (y + step / 2) / step - 1; // wraps around on the border
+        if (px < static_cast<std::size_t>(m_filtered->getSizeX()) && py < static_cast<std::size_t>(m_filtered->getSizeY()))
+        {
+            T value = m_filtered->getData()[py * m_filtered->getSizeX() + px];
+            return static_cast<sf::Uint8>(m_svmImage.valueLevel(value) * m_scale);
+        }
+    }
+
+    FaceIndex cell = m_svmImage(x, y);
+    if (m_svmImage.type(cell) == CellType::Original || m_svmImage.type(cell) == CellType::New)
+    {
+        return static_cast<sf::Uint8>(m_svmImage.value(cell) * m_scale);
+    }
+    return static_cast<sf::Uint8>((m_svmImage.min(cell) + m_svmImage.max(cell)) / static_cast<T>(2) * m_scale);
+}
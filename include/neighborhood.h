@@ -0,0 +1,38 @@
+#ifndef NEIGHBORHOOD_H
+#define NEIGHBORHOOD_H
+
+#include "svm_cell.h"
+#include <cstddef>
+
+// Neighbourhood of the faces of a row major grid (id = y * width + x).
+// The neighbours are precomputed as linear offsets: a face away from the border of the grid
+// (or of the rows it is restricted to) gets all of them without any bounds check.
+// The border ring takes a checked path instead of padding the grid, which would change the
+// FaceIndex layout shared by SVMImage, TOS and clean().
+class Neighborhood
+{
+public:
+    // <connectivity> is 4 or 8
+    Neighborhood(std::size_t width, std::size_t height, unsigned int connectivity = 8);
+
+    inline unsigned int connectivity() const;
+
+    // call <f>(neighbour) for each neighbour of the face <id> @ pos [x,y]
+    template <typename F>
+    inline void forEach(FaceIndex id, std::size_t x, std::size_t y, F f) const;
+    // same, only for the neighbours in rows [<yBegin>, <yEnd>)
+    template <typename F>
+    inline void forEach(FaceIndex id, std::size_t x, std::size_t y, std::size_t yBegin, std::size_t yEnd, F f) const;
+
+private:
+    std::size_t m_width, m_height;
+    unsigned int m_size;
+    // neighbours in row major order, as position shifts and as linear offsets
+    int m_dx[8];
+    int m_dy[8];
+    long int m_offset[8];
+};
+
+#include "neighborhood.hpp"
+
+#endif // NEIGHBORHOOD_H
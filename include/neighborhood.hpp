@@ -0,0 +1,52 @@
+#include "neighborhood.h"
+
+inline Neighborhood::Neighborhood(std::size_t width, std::size_t height, unsigned int connectivity)
+    : m_width(width), m_height(height), m_size(0)
+{
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            // 4-connectivity keeps the neighbours sharing an edge only
+            if ((dx == 0 && dy == 0) || (connectivity == 4 && dx != 0 && dy != 0))
+            {
+                continue;
+            }
+            m_dx[m_size] = dx;
+            m_dy[m_size] = dy;
+            m_offset[m_size] = dy * static_cast<long int>(width) + dx;
+            m_size++;
+        }
+    }
+}
+
+unsigned int Neighborhood::connectivity() const { return m_size; }
+
+template <typename F>
+void Neighborhood::forEach(FaceIndex id, std::size_t x, std::size_t y, F f) const
+{
+    forEach(id, x, y, 0, m_height, f);
+}
+
+template <typename F>
+void Neighborhood::forEach(FaceIndex id, std::size_t x, std::size_t y, std::size_t yBegin, std::size_t yEnd, F f) const
+{
+    if (x > 0 && x + 1 < m_width && y > yBegin && y + 1 < yEnd)
+    {
+        for (unsigned int k = 0; k < m_size; k++)
+        {
+            f(static_cast<FaceIndex>(id + m_offset[k]));
+        }
+        return;
+    }
+
+    for (unsigned int k = 0; k < m_size; k++)
+    {
+        long int nx = static_cast<long int>(x) + m_dx[k];
+        long int ny = static_cast<long int>(y) + m_dy[k];
+        if (nx >= 0 && nx < static_cast<long int>(m_width) && ny >= static_cast<long int>(yBegin) && ny < static_cast<long int>(yEnd))
+        {
+            f(static_cast<FaceIndex>(id + m_offset[k]));
+        }
+    }
+}
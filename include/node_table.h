@@ -0,0 +1,79 @@
+#ifndef NODE_TABLE_H
+#define NODE_TABLE_H
+
+#include "buffer_pool.h"
+#include "svm_cell.h"
+#include "tos.h"
+#include <cstddef>
+#include <cstdint>
+
+typedef FaceIndex NodeIndex;
+
+// Explicit nodes of a tree of shapes, numbered parents first (node 0 is the root, parent(n) < n for
+// the other nodes), with the node of each face, the children of each node in CSR arrays and the
+// preorder of the nodes, where each subtree is a range of positions.
+// It is built in two linear passes over the faces and a few over the nodes, from the canonical tree
+// (see TOS::canonicalParent()): on the interpolated tree, the Original cells are in the same node as
+// the interpolated faces around them.
+template <typename T>
+class NodeTable
+{
+public:
+    // children of a node, in increasing order
+    struct Children
+    {
+        const NodeIndex *first, *last;
+        const NodeIndex *begin() const { return first; }
+        const NodeIndex *end() const { return last; }
+        std::size_t size() const { return last - first; }
+    };
+
+    explicit NodeTable(const TOS<T> &tree);
+
+    inline const TOS<T> &tree() const;
+    inline std::size_t size() const; // number of nodes
+
+    // node of a face of the tree, and the canonical face of a node
+    inline NodeIndex node(FaceIndex face) const;
+    inline FaceIndex face(NodeIndex n) const;
+    inline NodeIndex parent(NodeIndex n) const; // the root is its own parent
+    inline Children children(NodeIndex n) const;
+    inline T level(NodeIndex n) const;           // as an image value
+    inline std::size_t depth(NodeIndex n) const; // 0 for the root
+
+    // preorder: the subtree of n is at the positions [position(n), position(n) + subtreeSize(n))
+    inline std::size_t position(NodeIndex n) const;
+    inline NodeIndex preorder(std::size_t position) const;
+    inline std::size_t subtreeSize(NodeIndex n) const;
+    // true if <a> is <n> or one of its ancestors, that is if the shape <n> is inside the shape <a>
+    inline bool isAncestor(NodeIndex a, NodeIndex n) const;
+
+    // size of the original image, and face of its pixel [x, y]
+    inline std::size_t pixelWidth() const;
+    inline std::size_t pixelHeight() const;
+    inline FaceIndex pixelFace(std::size_t x, std::size_t y) const;
+
+private:
+    const TOS<T> &m_tree;
+    std::size_t m_step; // distance between two pixels on the grid of the tree
+    std::size_t m_pixelWidth, m_pixelHeight;
+    Buffer<NodeIndex> m_node; // node of each face
+
+    // indexed by node
+    Buffer<FaceIndex> m_face;
+    Buffer<NodeIndex> m_parent;
+    Buffer<T> m_level;
+    Buffer<std::uint32_t> m_depth;
+    // children of n are m_children[m_childBegin[n]] to m_children[m_childBegin[n + 1] - 1]
+    Buffer<std::size_t> m_childBegin;
+    Buffer<NodeIndex> m_children;
+    Buffer<std::size_t> m_position;
+    Buffer<std::size_t> m_subtreeSize;
+
+    // indexed by position in preorder
+    Buffer<NodeIndex> m_preorder;
+};
+
+#include "node_table.hpp"
+
+#endif // NODE_TABLE_H
@@ -0,0 +1,138 @@
+#include "node_table.h"
+#include "profiler.h"
+
+template <typename T>
+NodeTable<T>::NodeTable(const TOS<T> &tree) : m_tree(tree)
+{
+    Profiler::Scope stage("nodes");
+    const SVMImage<T> &image = tree.image();
+    const Buffer<FaceIndex> &order = tree.order();
+    stage.items(order.size());
+
+    // parent() links the Original cells to Original cells: the nodes are those of the canonical tree
+    auto isCanonical = [&tree](FaceIndex f) {
+        FaceIndex p = tree.canonicalParent(f);
+        return p == f || tree.level(p) != tree.level(f);
+    };
+
+    std::size_t count = 0;
+    for (FaceIndex f : order)
+    {
+        count += isCanonical(f);
+    }
+    m_node.resize(image.width() * image.height());
+    m_face.resize(count);
+    m_parent.resize(count);
+    m_level.resize(count);
+    m_depth.resize(count);
+
+    // the parent of a face comes first in the order: its node is known
+    NodeIndex n = 0;
+    for (FaceIndex f : order)
+    {
+        FaceIndex p = tree.canonicalParent(f);
+        if (isCanonical(f))
+        {
+            m_face[n] = f;
+            m_level[n] = image.levelValue(tree.level(f));
+            m_parent[n] = p == f ? n : m_node[p];
+            m_depth[n] = p == f ? 0 : m_depth[m_parent[n]] + 1;
+            m_node[f] = n++;
+        }
+        else
+        {
+            m_node[f] = m_node[p];
+        }
+    }
+
+    // children by counting sort on the parent, the root excluded
+    m_childBegin.assign(count + 1, 0);
+    for (NodeIndex c = 1; c < count; c++)
+    {
+        m_childBegin[m_parent[c] + 1]++;
+    }
+    for (std::size_t i = 1; i <= count; i++)
+    {
+        m_childBegin[i] += m_childBegin[i - 1];
+    }
+    m_children.resize(count ? count - 1 : 0);
+    Buffer<std::size_t> next(m_childBegin.begin(), m_childBegin.end() - 1);
+    for (NodeIndex c = 1; c < count; c++)
+    {
+        m_children[next[m_parent[c]]++] = c;
+    }
+
+    // preorder, parents first: the children of a node follow it, each one after the subtree of the previous one
+    m_subtreeSize.assign(count, 1);
+    for (NodeIndex c = count; c-- > 1;)
+    {
+        m_subtreeSize[m_parent[c]] += m_subtreeSize[c];
+    }
+    m_position.resize(count);
+    m_preorder.resize(count);
+    if (count)
+    {
+        m_position[0] = 0;
+    }
+    for (NodeIndex p = 0; p < count; p++)
+    {
+        m_preorder[m_position[p]] = p;
+        std::size_t position = m_position[p] + 1;
+        for (NodeIndex c : children(p))
+        {
+            m_position[c] = position;
+            position += m_subtreeSize[c];
+        }
+    }
+
+    // the pixels are every 4 cells of the interpolated grid, or every cell once uninterpolated,
+    // after the median border
+    m_step = image.interpolated() ? 4 : 1;
+    m_pixelWidth = (image.width() + m_step - 1) / m_step - 2;
+    m_pixelHeight = (image.height() + m_step - 1) / m_step - 2;
+}
+
+template <typename T>
+const TOS<T> &NodeTable<T>::tree() const { return m_tree; }
+template <typename T>
+std::size_t NodeTable<T>::size() const { return m_face.size(); }
+
+template <typename T>
+NodeIndex NodeTable<T>::node(FaceIndex face) const { return m_node[face]; }
+template <typename T>
+FaceIndex NodeTable<T>::face(NodeIndex n) const { return m_face[n]; }
+template <typename T>
+NodeIndex NodeTable<T>::parent(NodeIndex n) const { return m_parent[n]; }
+template <typename T>
+typename NodeTable<T>::Children NodeTable<T>::children(NodeIndex n) const
+{
+    Children c = {m_children.data() + m_childBegin[n], m_children.data() + m_childBegin[n + 1]};
+    return c;
+}
+template <typename T>
+T NodeTable<T>::level(NodeIndex n) const { return m_level[n]; }
+template <typename T>
+std::size_t NodeTable<T>::depth(NodeIndex n) const { return m_depth[n]; }
+
+template <typename T>
+std::size_t NodeTable<T>::position(NodeIndex n) const { return m_position[n]; }
+template <typename T>
+NodeIndex NodeTable<T>::preorder(std::size_t position) const { return m_preorder[position]; }
+template <typename T>
+std::size_t NodeTable<T>::subtreeSize(NodeIndex n) const { return m_subtreeSize[n]; }
+template <typename T>
+bool NodeTable<T>::isAncestor(NodeIndex a, NodeIndex n) const
+{
+    // the difference wraps around if n is before a
+    return m_position[n] - m_position[a] < m_subtreeSize[a];
+}
+
+template <typename T>
+std::size_t NodeTable<T>::pixelWidth() const { return m_pixelWidth; }
+template <typename T>
+std::size_t NodeTable<T>::pixelHeight() const { return m_pixelHeight; }
+template <typename T>
+FaceIndex NodeTable<T>::pixelFace(std::size_t x, std::size_t y) const
+{
+    return static_cast<FaceIndex>(((y + 1) * m_tree.image().width() + x + 1) * m_step);
+}
@@ -0,0 +1,73 @@
+#ifndef PNM_FILE_H
+#define PNM_FILE_H
+
+#include "buffer_pool.h"
+#include "svm_cell.h"
+#include <Common/Image.h>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+// Input image file: grayscale PGM, binary (P5, 8 or 16 bits big endian) or ASCII (P2), or PFM (Pf).
+// A regular file is mapped in memory and its header is parsed in place; other files (pipes) are
+// read into a buffer. The 8-bit binary pixels are then used by image() without any copy, the other
+// formats are decoded into the image.
+// read() takes the next image of a stream of concatenated images instead of a whole file.
+class PNMFile
+{
+public:
+    PNMFile();
+    ~PNMFile();
+    PNMFile(const PNMFile &) = delete;
+    PNMFile &operator=(const PNMFile &) = delete;
+
+    // map or read <filename> and parse its header, false if it is not a supported image
+    bool open(const char *filename);
+    // read the next image of <stream>, up to its last pixel
+    bool read(std::FILE *stream, const char *name);
+    void close();
+    inline bool isOpen() const;
+    // true if only white spaces are left in <stream>
+    static bool endOfStream(std::FILE *stream);
+    // true if the file is mapped, false if it was read into a buffer
+    inline bool mapped() const;
+
+    inline std::size_t width() const;
+    inline std::size_t height() const;
+    // bits per pixel: 8 or 16 for a PGM, 32 for a PFM
+    inline int depth() const;
+
+    // pixels of the file, false if the type does not match depth(). The 8-bit binary pixels are a
+    // read only view on the file: <im> must then not outlive the PNMFile.
+    bool image(LibTIM::Image<LibTIM::U8> &im) const;
+    bool image(LibTIM::Image<LibTIM::U16> &im) const; // also reads 8-bit files
+    bool image(LibTIM::Image<float> &im) const;
+
+private:
+    // parse the header at the beginning of the file, setting m_pixels
+    bool parseHeader(const char *filename);
+    // true if the file holds all the binary pixels announced by the header
+    bool complete(const char *filename);
+    // header field starting at or after <pos>, skipping the white spaces and comments
+    std::string field(std::size_t &pos) const;
+    // read the values of a P2 file into <im>
+    template <typename T>
+    bool decodeAscii(LibTIM::Image<T> &im) const;
+
+private:
+    // whole file, mapped or read into m_buffer
+    const char *m_data;
+    std::size_t m_length;
+    bool m_mapped;
+    Buffer<char> m_buffer;
+
+    char m_format; // '2', '5' or 'f'
+    std::size_t m_width, m_height;
+    unsigned int m_maxValue;
+    float m_scale; // PFM scale, negative for little endian data
+    std::size_t m_pixels; // offset of the pixels in the file
+};
+
+#include "pnm_file.hpp"
+
+#endif // PNM_FILE_H
@@ -0,0 +1,412 @@
+#include "pnm_file.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+inline PNMFile::PNMFile()
+    : m_data(nullptr), m_length(0), m_mapped(false), m_format(0), m_width(0), m_height(0), m_maxValue(0), m_scale(0), m_pixels(0)
+{
+}
+
+inline PNMFile::~PNMFile()
+{
+    close();
+}
+
+inline bool PNMFile::open(const char *filename)
+{
+    close();
+
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Image file I/O error: " << filename << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            // the pixels are read once, front to back
+            madvise(data, st.st_size, MADV_SEQUENTIAL);
+            m_data = static_cast<const char *>(data);
+            m_length = st.st_size;
+            m_mapped = true;
+        }
+    }
+    if (!m_mapped)
+    {
+        // pipes and files that cannot be mapped are read by blocks
+        const std::size_t block = 1 << 20;
+        std::size_t length = 0;
+        ssize_t n;
+        do
+        {
+            m_buffer.resize(length + block);
+            n = ::read(fd, m_buffer.data() + length, block);
+            length += n > 0 ? n : 0;
+        } while (n > 0);
+        m_buffer.resize(length);
+        if (n < 0)
+        {
+            std::cerr << "Image file I/O error: " << filename << std::endl;
+            ::close(fd);
+            close();
+            return false;
+        }
+        m_data = m_buffer.data();
+        m_length = length;
+    }
+    ::close(fd);
+
+    if (!parseHeader(filename) || !complete(filename))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+inline bool PNMFile::read(std::FILE *stream, const char *name)
+{
+    close();
+
+    // header: the format and three fields, with the white space that ends the last one
+    int c = EOF;
+    for (int field = 0; field < 4; field++)
+    {
+        while ((c = std::getc(stream)) != EOF && (std::isspace(c) || c == '#'))
+        {
+            m_buffer.push_back(static_cast<char>(c));
+            if (c == '#')
+            {
+                while ((c = std::getc(stream)) != EOF && c != '\n')
+                {
+                    m_buffer.push_back(static_cast<char>(c));
+                }
+                m_buffer.push_back('\n');
+            }
+        }
+        while (c != EOF && !std::isspace(c))
+        {
+            m_buffer.push_back(static_cast<char>(c));
+            c = std::getc(stream);
+        }
+        if (c != EOF)
+        {
+            m_buffer.push_back(static_cast<char>(c));
+        }
+    }
+    m_data = m_buffer.data();
+    m_length = m_buffer.size();
+    if (!parseHeader(name))
+    {
+        close();
+        return false;
+    }
+
+    if (m_format == '2')
+    {
+        // the pixels of a P2 image end with its last value
+        std::size_t values = 0;
+        while (values < m_width * m_height && (c = std::getc(stream)) != EOF)
+        {
+            m_buffer.push_back(static_cast<char>(c));
+            if (c == '#')
+            {
+                while ((c = std::getc(stream)) != EOF && c != '\n')
+                {
+                    m_buffer.push_back(static_cast<char>(c));
+                }
+                m_buffer.push_back('\n');
+            }
+            else if (std::isdigit(c))
+            {
+                while ((c = std::getc(stream)) != EOF && std::isdigit(c))
+                {
+                    m_buffer.push_back(static_cast<char>(c));
+                }
+                if (c != EOF)
+                {
+                    std::ungetc(c, stream);
+                }
+                values++;
+            }
+        }
+    }
+    else
+    {
+        std::size_t bytes = m_width * m_height * (m_format == 'f' ? sizeof(float) : depth() / 8);
+        std::size_t length = m_buffer.size();
+        m_buffer.resize(length + bytes);
+        m_buffer.resize(length + std::fread(m_buffer.data() + length, 1, bytes, stream));
+    }
+    m_data = m_buffer.data();
+    m_length = m_buffer.size();
+    if (!complete(name))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+inline bool PNMFile::endOfStream(std::FILE *stream)
+{
+    int c;
+    while ((c = std::getc(stream)) != EOF && std::isspace(c))
+    {
+    }
+    if (c == EOF)
+    {
+        return true;
+    }
+    std::ungetc(c, stream);
+    return false;
+}
+
+inline void PNMFile::close()
+{
+    if (m_mapped)
+    {
+        munmap(const_cast<char *>(m_data), m_length);
+    }
+    Buffer<char>().swap(m_buffer);
+    m_data = nullptr;
+    m_length = 0;
+    m_mapped = false;
+    m_format = 0;
+    m_width = m_height = 0;
+    m_maxValue = 0;
+    m_scale = 0;
+    m_pixels = 0;
+}
+
+inline bool PNMFile::isOpen() const { return m_format != 0; }
+inline bool PNMFile::mapped() const { return m_mapped; }
+inline std::size_t PNMFile::width() const { return m_width; }
+inline std::size_t PNMFile::height() const { return m_height; }
+inline int PNMFile::depth() const
+{
+    if (m_format == 'f')
+    {
+        return 32;
+    }
+    return m_maxValue < 256 ? 8 : 16;
+}
+
+inline std::string PNMFile::field(std::size_t &pos) const
+{
+    while (pos < m_length && (std::isspace(static_cast<unsigned char>(m_data[pos])) || m_data[pos] == '#'))
+    {
+        if (m_data[pos] == '#')
+        {
+            while (pos < m_length && m_data[pos] != '\n')
+            {
+                pos++;
+            }
+        }
+        else
+        {
+            pos++;
+        }
+    }
+    std::size_t begin = pos;
+    while (pos < m_length && !std::isspace(static_cast<unsigned char>(m_data[pos])))
+    {
+        pos++;
+    }
+    return std::string(m_data + begin, pos - begin);
+}
+
+inline bool PNMFile::parseHeader(const char *filename)
+{
+    std::size_t pos = 0;
+    std::string format = field(pos);
+    if (format != "P2" && format != "P5" && format != "Pf")
+    {
+        std::cerr << "Unsupported image format in " << filename << ", expected a PGM (P5, P2) or grayscale PFM (Pf) image"
+                  << std::endl;
+        return false;
+    }
+
+    std::string width = field(pos), height = field(pos), last = field(pos);
+    char *end;
+    unsigned long w = std::strtoul(width.c_str(), &end, 10);
+    bool valid = !width.empty() && *end == 0;
+    unsigned long h = std::strtoul(height.c_str(), &end, 10);
+    valid = valid && !height.empty() && *end == 0 && w > 0 && h > 0;
+    if (format == "Pf")
+    {
+        m_scale = std::strtof(last.c_str(), &end);
+        valid = valid && !last.empty() && *end == 0 && m_scale != 0;
+    }
+    else
+    {
+        m_maxValue = std::strtoul(last.c_str(), &end, 10);
+        valid = valid && !last.empty() && *end == 0 && m_maxValue > 0 && m_maxValue < 65536;
+    }
+    // a single white space separates the header from the pixels
+    if (!valid || pos >= m_length)
+    {
+        std::cerr << "Invalid image header in " << filename << std::endl;
+        return false;
+    }
+    if (w > std::numeric_limits<LibTIM::TSize>::max() || h > std::numeric_limits<LibTIM::TSize>::max())
+    {
+        std::cerr << "Image " << filename << " is too large (" << w << "x" << h << ")" << std::endl;
+        return false;
+    }
+    if (!gridFits(w, h))
+    {
+        std::cerr << "Image " << filename << " is too large (" << w << "x" << h << ") for " << 8 * sizeof(FaceIndex)
+                  << "-bit face indices, build with TOS_WIDE_INDEX" << std::endl;
+        return false;
+    }
+
+    m_format = format[1];
+    m_width = w;
+    m_height = h;
+    m_pixels = pos + 1;
+    return true;
+}
+
+inline bool PNMFile::complete(const char *filename)
+{
+    std::size_t bytes = m_format == 'f' ? sizeof(float) : m_format == '5' ? depth() / 8 : 0;
+    if (m_length - m_pixels < m_width * m_height * bytes)
+    {
+        std::cerr << "Image file " << filename << " is truncated" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool PNMFile::decodeAscii(LibTIM::Image<T> &im) const
+{
+    im.setSize(m_width, m_height, 1);
+    T *data = im.getData();
+    std::size_t pos = m_pixels;
+    for (std::size_t i = 0; i < m_width * m_height; i++)
+    {
+        while (pos < m_length && !std::isdigit(static_cast<unsigned char>(m_data[pos])))
+        {
+            if (m_data[pos] == '#')
+            {
+                while (pos < m_length && m_data[pos] != '\n')
+                {
+                    pos++;
+                }
+            }
+            else if (!std::isspace(static_cast<unsigned char>(m_data[pos])))
+            {
+                return false;
+            }
+            else
+            {
+                pos++;
+            }
+        }
+        if (pos == m_length)
+        {
+            return false;
+        }
+        unsigned int value = 0;
+        while (pos < m_length && std::isdigit(static_cast<unsigned char>(m_data[pos])) && value <= m_maxValue)
+        {
+            value = value * 10 + (m_data[pos++] - '0');
+        }
+        if (value > m_maxValue)
+        {
+            return false;
+        }
+        data[i] = static_cast<T>(value);
+    }
+    return true;
+}
+
+inline bool PNMFile::image(LibTIM::Image<LibTIM::U8> &im) const
+{
+    if (!isOpen() || depth() != 8)
+    {
+        return false;
+    }
+    if (m_format == '2')
+    {
+        return decodeAscii(im);
+    }
+    im.setView(m_width, m_height, reinterpret_cast<const LibTIM::U8 *>(m_data + m_pixels));
+    return true;
+}
+
+inline bool PNMFile::image(LibTIM::Image<LibTIM::U16> &im) const
+{
+    if (!isOpen() || depth() > 16)
+    {
+        return false;
+    }
+    if (m_format == '2')
+    {
+        return decodeAscii(im);
+    }
+
+    im.setSize(m_width, m_height, 1);
+    LibTIM::U16 *data = im.getData();
+    const unsigned char *pixels = reinterpret_cast<const unsigned char *>(m_data + m_pixels);
+    std::size_t n = m_width * m_height;
+    if (depth() == 8)
+    {
+        // one byte per sample
+        std::copy(pixels, pixels + n, data);
+    }
+    else
+    {
+        // two bytes per sample, most significant byte first
+        for (std::size_t i = 0; i < n; i++)
+        {
+            data[i] = static_cast<LibTIM::U16>((pixels[2 * i] << 8) | pixels[2 * i + 1]);
+        }
+    }
+    return true;
+}
+
+inline bool PNMFile::image(LibTIM::Image<float> &im) const
+{
+    if (!isOpen() || m_format != 'f')
+    {
+        return false;
+    }
+
+    im.setSize(m_width, m_height, 1);
+    const unsigned int one = 1;
+    bool littleEndianHost = *reinterpret_cast<const unsigned char *>(&one) == 1;
+    bool swap = (m_scale < 0) != littleEndianHost;
+
+    // rows are stored bottom to top, not necessarily aligned in the file
+    for (std::size_t y = 0; y < m_height; y++)
+    {
+        float *row = im.getData() + (m_height - 1 - y) * m_width;
+        std::memcpy(row, m_data + m_pixels + y * m_width * sizeof(float), m_width * sizeof(float));
+        if (swap)
+        {
+            for (std::size_t x = 0; x < m_width; x++)
+            {
+                unsigned char *b = reinterpret_cast<unsigned char *>(row + x);
+                std::swap(b[0], b[3]);
+                std::swap(b[1], b[2]);
+            }
+        }
+    }
+    return true;
+}
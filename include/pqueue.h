@@ -2,53 +2,50 @@
 #define PQUEUE_H
 
 #include "svm_cell.h"
-#include <deque>
+#include <cstdint>
+#include <limits>
 #include <ostream>
 #include <sstream>
 #include <vector>
-#include <map>
 
+// Hierarchical queue: one FIFO bucket per level, plus a two-level occupancy bitmap
+// to find the next non-empty level without scanning the buckets, even with 65536 levels.
 template <typename T>
 class PQueue
 {
 public:
-    PQueue();
+    // <nbLevels> is the number of levels the queue can hold, levels are in [0, nbLevels)
+    PQueue(std::size_t nbLevels = static_cast<std::size_t>(std::numeric_limits<T>::max()) + 1);
 
     // push <cell> in queue at level <level>
-    void push(SVMCell<T> *cell, std::size_t level);
+    inline void push(FaceIndex cell, std::size_t level);
     // pop the cell at <level> and returns it
-    SVMCell<T> *pop(std::size_t level);
+    inline FaceIndex pop(std::size_t level);
 
-    // push <cell> in queue, with level <level> used to find definitive level
-    void priority_push(SVMCell<T> *cell, std::size_t level);
+    // push <cell> of value range [<min>, <max>] in queue, with level <level> used to find definitive level
+    inline void priority_push(FaceIndex cell, T min, T max, std::size_t level);
     // pop the next cell to handle, with level <level> used to find the next one to read
-    SVMCell<T> *priority_pop(std::size_t *level);
+    inline FaceIndex priority_pop(std::size_t *level);
 
-    // get the number of queues up to the last non-empty queue
-    std::size_t size() const;
+    // get the number of cells in the queue
+    inline std::size_t size() const;
     // check if the PQueue is empty
-    bool empty() const;
+    inline bool empty() const;
 
     friend std::ostream &operator<<(std::ostream &o, const PQueue &pq)
     {
         std::stringstream ss;
         ss << "{";
-        for (auto qq : pq.m_pqueue)
+        for (std::size_t l = 0; l < pq.m_buckets.size(); l++)
         {
-            auto q = qq.second;
-            ss << "[";
-            for (int i = 0; i < q.size(); i++)
+            if (!pq.occupied(l))
             {
-                if(q[i]->type() == CellType::New || q[i]->type() == CellType::Original)
-                {
-                    ss << static_cast<unsigned int>(q[i]->value());
-                    ss << "(" << q[i]->posX() << "," << q[i]->posY() << ") ";
-                }
-                else
-                {
-                    ss << "<" << static_cast<unsigned int>(q[i]->min()) << "," << static_cast<unsigned int>(q[i]->max()) << ">";
-                    ss << "(" << q[i]->posX() << "," << q[i]->posY() << ") ";
-                }
+                continue;
+            }
+            ss << l << ":[";
+            for (std::size_t i = pq.m_heads[l]; i < pq.m_buckets[l].size(); i++)
+            {
+                ss << pq.m_buckets[l][i] << " ";
             }
             ss << "] ";
         }
@@ -57,7 +54,19 @@ public:
     }
 
 private:
-    std::map<unsigned int, std::deque<SVMCell<T> *>> m_pqueue;
+    inline bool occupied(std::size_t level) const;
+    inline void setOccupied(std::size_t level);
+    inline void clearOccupied(std::size_t level);
+    // first non-empty level >= <level>, or m_buckets.size() if there is none
+    inline std::size_t nextOccupied(std::size_t level) const;
+    // last non-empty level <= <level>, or m_buckets.size() if there is none
+    inline std::size_t prevOccupied(std::size_t level) const;
+
+    std::vector<std::vector<FaceIndex>> m_buckets;
+    std::vector<std::size_t> m_heads;      // read position of each bucket
+    std::vector<std::uint64_t> m_occupied; // bit l is set if bucket l is not empty
+    std::vector<std::uint64_t> m_summary;  // bit w is set if m_occupied[w] is not 0
+    std::size_t m_size;                    // number of pending cells
 };
 
 #include "pqueue.hpp"
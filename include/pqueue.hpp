@@ -1,50 +1,48 @@
 #include "pqueue.h"
 
 template <typename T>
-PQueue<T>::PQueue()
+PQueue<T>::PQueue(std::size_t nbLevels) : m_buckets(nbLevels), m_heads(nbLevels, 0), m_occupied((nbLevels + 63) / 64, 0),
+                                         m_summary((nbLevels + 64 * 64 - 1) / (64 * 64), 0), m_size(0)
 {
 }
 
 template <typename T>
-void PQueue<T>::push(SVMCell<T> *cell, std::size_t level)
+void PQueue<T>::push(FaceIndex cell, std::size_t level)
 {
-    try {
-        m_pqueue.at(level);
-    } catch (const std::out_of_range &oor) {
-        m_pqueue.insert(std::pair<unsigned int,std::deque<SVMCell<T>*>>(level,std::deque<SVMCell<T> *>()));
+    std::vector<FaceIndex> &bucket = m_buckets[level];
+    if (bucket.empty())
+    {
+        setOccupied(level);
     }
-    m_pqueue.at(level).push_back(cell);
+    bucket.push_back(cell);
+    m_size++;
 }
 
 template <typename T>
-SVMCell<T> *PQueue<T>::pop(std::size_t level)
+FaceIndex PQueue<T>::pop(std::size_t level)
 {
+    std::vector<FaceIndex> &bucket = m_buckets[level];
     // retrieve the front element
-    SVMCell<T> *cell = m_pqueue.at(level).front();
-    // delete the front element
-    m_pqueue.at(level).pop_front();
+    FaceIndex cell = bucket[m_heads[level]++];
+    // the bucket is consumed: reset it, keeping its memory for the next pushes
+    if (m_heads[level] == bucket.size())
+    {
+        bucket.clear();
+        m_heads[level] = 0;
+        clearOccupied(level);
+    }
+    m_size--;
 
     return cell;
 }
 
 template <typename T>
-void PQueue<T>::priority_push(SVMCell<T> *cell, std::size_t level)
+void PQueue<T>::priority_push(FaceIndex cell, T min, T max, std::size_t level)
 {
-    std::size_t lower;
-    std::size_t upper;
+    std::size_t lower = static_cast<std::size_t>(min);
+    std::size_t upper = static_cast<std::size_t>(max);
     std::size_t levelToPush;
 
-    if (cell->type() == CellType::Inter2 || cell->type() == CellType::Inter4)
-    {
-        lower = static_cast<std::size_t>(cell->min());
-        upper = static_cast<std::size_t>(cell->max());
-    }
-    else
-    {
-        lower = static_cast<std::size_t>(cell->value());
-        upper = static_cast<std::size_t>(cell->value());
-    }
-
     if (lower > level)
     {
         levelToPush = lower;
@@ -62,35 +60,122 @@ void PQueue<T>::priority_push(SVMCell<T> *cell, std::size_t level)
 }
 
 template <typename T>
-SVMCell<T> *PQueue<T>::priority_pop(std::size_t *level)
+FaceIndex PQueue<T>::priority_pop(std::size_t *level)
 {
-    //std::size_t currentLevel = *level;
-    while (m_pqueue[*level].size() == 0)
+    if (!occupied(*level))
     {
-        *level = (*level + 1) % m_pqueue.size();
+        // the next level is the closest non-empty one, upwards or downwards
+        std::size_t up = nextOccupied(*level);
+        std::size_t down = prevOccupied(*level);
+        if (down == m_buckets.size() || (up != m_buckets.size() && up - *level <= *level - down))
+        {
+            *level = up;
+        }
+        else
+        {
+            *level = down;
+        }
     }
     return (pop(*level));
 }
 
 template <typename T>
-std::size_t PQueue<T>::size() const
+bool PQueue<T>::occupied(std::size_t level) const
 {
-    return m_pqueue.size();
+    return (m_occupied[level >> 6] >> (level & 63)) & 1;
 }
 
 template <typename T>
-bool PQueue<T>::empty() const
+void PQueue<T>::setOccupied(std::size_t level)
 {
-    if(m_pqueue.size() == 0) {
-        return true;
+    m_occupied[level >> 6] |= std::uint64_t(1) << (level & 63);
+    m_summary[level >> 12] |= std::uint64_t(1) << ((level >> 6) & 63);
+}
+
+template <typename T>
+void PQueue<T>::clearOccupied(std::size_t level)
+{
+    m_occupied[level >> 6] &= ~(std::uint64_t(1) << (level & 63));
+    if (m_occupied[level >> 6] == 0)
+    {
+        m_summary[level >> 12] &= ~(std::uint64_t(1) << ((level >> 6) & 63));
     }
+}
 
-    for(auto it = m_pqueue.begin(); it != m_pqueue.end(); it++)
+template <typename T>
+std::size_t PQueue<T>::nextOccupied(std::size_t level) const
+{
+    std::size_t word = level >> 6;
+    if (word >= m_occupied.size())
+    {
+        return m_buckets.size();
+    }
+    // mask out the levels below <level> in the first word
+    std::uint64_t bits = m_occupied[word] & (~std::uint64_t(0) << (level & 63));
+    if (bits != 0)
     {
-        if (!(*it).second.empty())
+        return (word << 6) + __builtin_ctzll(bits);
+    }
+
+    // then look for the next non-empty word in the summary
+    std::size_t next = word + 1;
+    std::size_t block = next >> 6;
+    if (block >= m_summary.size())
+    {
+        return m_buckets.size();
+    }
+    std::uint64_t words = m_summary[block] & (~std::uint64_t(0) << (next & 63));
+    while (words == 0)
+    {
+        if (++block == m_summary.size())
+        {
+            return m_buckets.size();
+        }
+        words = m_summary[block];
+    }
+    word = (block << 6) + __builtin_ctzll(words);
+    return (word << 6) + __builtin_ctzll(m_occupied[word]);
+}
+
+template <typename T>
+std::size_t PQueue<T>::prevOccupied(std::size_t level) const
+{
+    std::size_t word = level >> 6;
+    // mask out the levels above <level> in the first word
+    std::uint64_t bits = m_occupied[word] & (~std::uint64_t(0) >> (63 - (level & 63)));
+    if (bits != 0)
+    {
+        return (word << 6) + 63 - __builtin_clzll(bits);
+    }
+
+    // then look for the previous non-empty word in the summary
+    if (word == 0)
+    {
+        return m_buckets.size();
+    }
+    std::size_t prev = word - 1;
+    std::size_t block = prev >> 6;
+    std::uint64_t words = m_summary[block] & (~std::uint64_t(0) >> (63 - (prev & 63)));
+    while (words == 0)
+    {
+        if (block-- == 0)
         {
-            return false;
+            return m_buckets.size();
         }
+        words = m_summary[block];
     }
-    return true;
+    word = (block << 6) + 63 - __builtin_clzll(words);
+    return (word << 6) + 63 - __builtin_clzll(m_occupied[word]);
+}
+
+template <typename T>
+std::size_t PQueue<T>::size() const
+{
+    return m_size;
+}
+
+template <typename T>
+bool PQueue<T>::empty() const
+{
+    return m_size == 0;
 }
@@ -0,0 +1,79 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Per-stage instrumentation: wall and CPU time, peak resident memory, allocations of the flat
+// arrays (see BufferPool) and number of items processed. Stages with the same name are summed,
+// e.g. over the images of a batch; CPU time and allocations are process wide.
+class Profiler
+{
+public:
+    struct Stage
+    {
+        std::string name;
+        std::size_t calls;
+        double wall;          // milliseconds
+        double cpu;           // milliseconds
+        std::size_t peakRss;  // kilobytes, at the end of the stage
+        std::size_t allocations;
+        std::size_t allocatedBytes;
+        std::size_t items;
+    };
+
+    // Measure a stage from its construction to its destruction
+    class Scope
+    {
+    public:
+        Scope(const char *name);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        // number of items (pixels, cells...) processed by the stage
+        inline void items(std::size_t n);
+
+    private:
+        const char *m_name;
+        bool m_enabled;
+        double m_wall, m_cpu;
+        std::size_t m_allocations, m_allocatedBytes;
+        std::size_t m_items;
+    };
+
+    static Profiler &instance();
+
+    inline void enable(bool enabled);
+    inline bool enabled() const;
+
+    // recorded stages, in order of first use
+    std::vector<Stage> stages() const;
+    // forget the recorded stages
+    void reset();
+
+    // human readable table
+    void print(std::ostream &o) const;
+    // JSON report
+    bool writeJson(const char *filename) const;
+
+private:
+    Profiler() : m_enabled(false) {}
+    void record(const Stage &stage);
+
+    // current wall, process CPU times in milliseconds, peak RSS in kilobytes
+    static double wallTime();
+    static double cpuTime();
+    static std::size_t peakRss();
+
+    bool m_enabled;
+    mutable std::mutex m_mutex;
+    std::vector<Stage> m_stages; // in order of first use
+};
+
+#include "profiler.hpp"
+
+#endif // PROFILER_H
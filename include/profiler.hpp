@@ -0,0 +1,138 @@
+#include "buffer_pool.h"
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sys/resource.h>
+
+inline Profiler &Profiler::instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::enable(bool enabled) { m_enabled = enabled; }
+bool Profiler::enabled() const { return m_enabled; }
+
+inline double Profiler::wallTime()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline double Profiler::cpuTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+inline std::size_t Profiler::peakRss()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+inline void Profiler::record(const Stage &stage)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Stage &s : m_stages)
+    {
+        if (s.name == stage.name)
+        {
+            s.calls += stage.calls;
+            s.wall += stage.wall;
+            s.cpu += stage.cpu;
+            s.peakRss = std::max(s.peakRss, stage.peakRss);
+            s.allocations += stage.allocations;
+            s.allocatedBytes += stage.allocatedBytes;
+            s.items += stage.items;
+            return;
+        }
+    }
+    m_stages.push_back(stage);
+}
+
+inline std::vector<Profiler::Stage> Profiler::stages() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stages;
+}
+
+inline void Profiler::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stages.clear();
+}
+
+inline void Profiler::print(std::ostream &o) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    o << std::left << std::setw(16) << "stage" << std::right << std::setw(7) << "calls" << std::setw(12) << "wall ms"
+      << std::setw(12) << "cpu ms" << std::setw(14) << "peak RSS MB" << std::setw(9) << "allocs" << std::setw(12)
+      << "alloc MB" << std::setw(14) << "items" << std::setw(14) << "items/s" << "\n";
+    o << std::fixed << std::setprecision(1);
+    for (const Stage &s : m_stages)
+    {
+        o << std::left << std::setw(16) << s.name << std::right << std::setw(7) << s.calls << std::setw(12) << s.wall
+          << std::setw(12) << s.cpu << std::setw(14) << s.peakRss / 1024.0 << std::setw(9) << s.allocations
+          << std::setw(12) << s.allocatedBytes / (1024.0 * 1024.0) << std::setw(14) << s.items << std::setw(14)
+          << std::setprecision(0) << (s.wall > 0 ? s.items / s.wall * 1e3 : 0) << std::setprecision(1) << "\n";
+    }
+    o << std::defaultfloat << std::setprecision(6) << std::flush;
+}
+
+inline bool Profiler::writeJson(const char *filename) const
+{
+    std::ofstream file(filename, std::ios_base::out | std::ios_base::trunc);
+    if (!file)
+    {
+        std::cerr << "Stats file I/O error: " << filename << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    file << "{\n  \"stages\": [";
+    for (std::size_t i = 0; i < m_stages.size(); i++)
+    {
+        const Stage &s = m_stages[i];
+        file << (i ? "," : "") << "\n    {\"name\": \"" << s.name << "\", \"calls\": " << s.calls << ", \"wall_ms\": " << s.wall
+             << ", \"cpu_ms\": " << s.cpu << ", \"peak_rss_kb\": " << s.peakRss << ", \"allocations\": " << s.allocations
+             << ", \"allocated_bytes\": " << s.allocatedBytes << ", \"items\": " << s.items << "}";
+    }
+    file << "\n  ]\n}\n";
+    return static_cast<bool>(file);
+}
+
+inline Profiler::Scope::Scope(const char *name) : m_name(name), m_enabled(Profiler::instance().enabled()), m_items(0)
+{
+    if (m_enabled)
+    {
+        m_wall = wallTime();
+        m_cpu = cpuTime();
+        m_allocations = BufferPool::instance().allocations();
+        m_allocatedBytes = BufferPool::instance().allocatedBytes();
+    }
+}
+
+inline Profiler::Scope::~Scope()
+{
+    if (m_enabled)
+    {
+        Stage stage;
+        stage.name = m_name;
+        stage.calls = 1;
+        stage.wall = wallTime() - m_wall;
+        stage.cpu = cpuTime() - m_cpu;
+        stage.peakRss = peakRss();
+        stage.allocations = BufferPool::instance().allocations() - m_allocations;
+        stage.allocatedBytes = BufferPool::instance().allocatedBytes() - m_allocatedBytes;
+        stage.items = m_items;
+        Profiler::instance().record(stage);
+    }
+}
+
+void Profiler::Scope::items(std::size_t n) { m_items = n; }
@@ -2,9 +2,31 @@
 #define SVM_CELL_H
 
 #include <cstddef> // for size_t
+#include <cstdint>
 
-// A SVMCell represent a Set Value Map Cell, which compose a Set Value Map
-// A SVMCell can be of four types:
+// A cell (or face) of a Set Value Map is no longer stored as an object: the SVMImage keeps
+// its values in flat arrays and the TOS keeps the tree in flat arrays, both indexed by FaceIndex.
+// On 32 bits, the interpolated grid is limited to about 16k x 16k original pixels: build with
+// TOS_WIDE_INDEX for larger images, at the cost of twice the memory for the tree arrays.
+#ifdef TOS_WIDE_INDEX
+typedef std::uint64_t FaceIndex;
+#else
+typedef std::uint32_t FaceIndex;
+#endif
+
+// marker for "no face", used for unset parent/zpar links
+static const FaceIndex NO_FACE = static_cast<FaceIndex>(-1);
+
+// true if the cells of the interpolated grid of a <width> x <height> image, extended with its
+// border, can be indexed by FaceIndex
+inline bool gridFits(std::size_t width, std::size_t height)
+{
+    std::size_t w = 4 * (width + 2) - 3;
+    std::size_t h = 4 * (height + 2) - 3;
+    return h <= static_cast<std::size_t>(NO_FACE) / w && w * h < static_cast<std::size_t>(NO_FACE);
+}
+
+// A cell of a Set Value Map can be of four types:
 enum CellType
 {
     Original = 0, // a cell directly generated from the original 2D image, holding the value of the original pixel
@@ -30,64 +52,23 @@ enum CellType
 //  |     0    |  (8..24)  |   (24)   | (24..24)   |    24    |
 //  |__________|___________|__________|____________|__________|
 //
-template <typename T>
-class SVMCell
+// The type of a cell only depends on its coordinates in the interpolated grid:
+// Original cells are every 4 cells, Inter2/Inter4 cells have one/two odd coordinates.
+inline CellType cellType(std::size_t x, std::size_t y)
 {
-public:
-    SVMCell();
-    SVMCell(CellType t, T a, T b = 0);
-
-    // setters
-    inline void type(CellType type);
-    inline void value(T value);
-    inline void min(T min);
-    inline void max(T max);
-    inline void visited(bool visited);
-    inline void posX(int x);
-    inline void posY(int y);
-    inline void level(std::size_t l);
-    inline void parent(SVMCell<T> *parent);
-    inline void zpar(SVMCell<T> *zpar);
-
-    // getters
-    inline CellType type() const;
-    inline T value() const;
-    inline T min() const;
-    inline T max() const;
-    inline bool visited() const;
-    inline int posX() const;
-    inline int posY() const;
-    inline std::size_t level() const;
-    inline SVMCell<T> *parent() const;
-    inline SVMCell<T> *zpar() const;
-
-private:
-    // image interpolation
-    CellType m_type;     // type of the cell, determine if m_value or m_in/m_max is used
-    bool m_visited;      // if the cell as been visited
-    std::size_t m_level; // memorization of the level where the queue handled the face
-    int m_x, m_y;        // cell coordinates in the SVMImage
-
-    // tree generation
-    SVMCell<T> *m_parent;
-    SVMCell<T> *m_zpar;
-
-    union {
-        struct
-        {
-            T m_value; // the value of the cell, for Original and New type
-        };
-        struct
-        {
-            T m_min; // the value range, for Inter2/4 type
-            T m_max;
-        };
-    };
-};
-
-template <typename T>
-bool areSameVal(const SVMCell<T> &a, const SVMCell<T> &b);
-
-#include "svm_cell.hpp"
+    if ((x & 1) && (y & 1))
+    {
+        return CellType::Inter4;
+    }
+    if ((x & 1) || (y & 1))
+    {
+        return CellType::Inter2;
+    }
+    if ((x & 3) == 0 && (y & 3) == 0)
+    {
+        return CellType::Original;
+    }
+    return CellType::New;
+}
 
 #endif // SVM_CELL_H
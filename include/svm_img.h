@@ -1,45 +1,101 @@
 #ifndef SVM_IMG_H
 #define SVM_IMG_H
 
+#include "buffer_pool.h"
 #include "svm_cell.h"
 #include <Common/Image.h>
 #include <SFML/Graphics/Image.hpp>
+#include <type_traits>
 #include <vector>
 
 template <typename T>
 class TOS;
 
-// A SVMImage represent a Set Value Map image and is composed of SVMCell.
+// A SVMImage represent a Set Value Map image. Cells are not stored as objects but as
+// structure of arrays indexed by FaceIndex (row major, id = y * width + x).
+// In implicit mode, the interpolated grid is never materialized: the value of a cell is
+// computed on the fly from the (extended) original pixels around it.
+// With the rank transform, the pixel values are replaced by their rank among the distinct values
+// of the extended image: the tree is the same but its levels are dense, whatever the range of T.
 template <typename T>
 class SVMImage
 {
 public:
-    SVMImage(const LibTIM::Image<T> &img);
-
-    // read only public acces to image data
-    const std::vector<SVMCell<T> *> &data() const;
+    // the rank transform is always used for non integral types
+    SVMImage(const LibTIM::Image<T> &img, bool implicit = false, bool rank = false);
 
     inline void width(std::size_t w);
     inline void height(std::size_t h);
     inline std::size_t width() const;
     inline std::size_t height() const;
 
-    // getter for a pixel @ pos [i,j]
-    SVMCell<T> *operator()(std::size_t i, std::size_t j);
+    // number of cells in the image
+    inline std::size_t size() const;
+    // true while the image holds the interpolated grid
+    inline bool interpolated() const;
+    // true if the cell values are computed on the fly
+    inline bool implicit() const;
+    // true if the cell values are ranks, see levelValue()
+    inline bool ranked() const;
+
+    // index of the cell @ pos [i,j]
+    inline FaceIndex operator()(std::size_t i, std::size_t j) const;
+
+    // read only access to cell data
+    inline CellType type(FaceIndex id) const;
+    inline T value(FaceIndex id) const; // for Original and New cells
+    inline T min(FaceIndex id) const;   // value range, for Inter2/4 cells (min == max == value otherwise)
+    inline T max(FaceIndex id) const;
+    inline void range(FaceIndex id, T &min, T &max) const;
+    // highest value of the image, levels are in [0, maxValue()]
+    inline T maxValue() const;
+    // value of the original image for the level <level> of a cell
+    inline T levelValue(T level) const;
+    // level of a value of the original image, inverse of levelValue()
+    inline T valueLevel(T value) const;
+    inline std::size_t posX(FaceIndex id) const;
+    inline std::size_t posY(FaceIndex id) const;
+
     void uninterpolate(TOS<T> *tree);
 
 private:
+    // integral types of at most 16 bits use tables indexed by value instead of sorting
+    typedef std::integral_constant<bool, std::is_integral<T>::value && sizeof(T) <= 2> SmallIntegral;
+
     // add 1 pixel at the border of value median(Image)
-    void extend();
+    void extend(const LibTIM::Image<T> &img);
+    // median of the original image, by histogram or by selection: with v the sorted pixel
+    // values and k = (n - 1) / 2, it is (v[k] + v[k + 1]) / 2 if n - 1 is even, v[k] otherwise
+    T medianValue(const LibTIM::Image<T> &img, std::true_type) const;
+    T medianValue(const LibTIM::Image<T> &img, std::false_type) const;
+    // replace the values of the extended image by their rank, filling m_levels
+    void rankTransform(std::true_type);
+    void rankTransform(std::false_type);
 
     // interpolate the image
     void interpolate();
 
+    // value range of the cell @ pos [x,y] of the interpolated grid, computed from m_extended
+    inline void implicitRange(std::size_t x, std::size_t y, T &min, T &max) const;
+    // value of the Original or New cell @ pos [x,y] of the interpolated grid
+    inline T implicitValue(std::size_t x, std::size_t y) const;
+
 private:
     std::size_t m_height, m_width;
+    bool m_interpolated;
+    bool m_implicit;
+    bool m_rank;
 
-    std::vector<SVMCell<T> *> m_image;
-    LibTIM::Image<T> m_original;
+    // cell values of the interpolated grid, min == max for Original and New cells
+    // (empty in implicit mode and once uninterpolated)
+    Buffer<T> m_min;
+    Buffer<T> m_max;
+    // original image with its median border, m_extWidth x m_extHeight
+    Buffer<T> m_extended;
+    std::size_t m_extWidth, m_extHeight;
+    T m_maxValue;
+    // rank -> value table of the rank transform, empty without it
+    Buffer<T> m_levels;
 };
 
 #include "svm_img.hpp"
@@ -1,66 +1,180 @@
+#include "profiler.h"
 #include "svm_img.h"
 #include "utils.h"
 #include <algorithm>
+#include <limits>
+#include <stdexcept>
 #include <omp.h>
+#include <type_traits>
 #include <vector>
 template <typename T>
-SVMImage<T>::SVMImage(const LibTIM::Image<T> &img) : m_original(img)
+SVMImage<T>::SVMImage(const LibTIM::Image<T> &img, bool implicit, bool rank)
+    : m_interpolated(false), m_implicit(implicit), m_rank(rank || !std::is_integral<T>::value)
 {
     m_width = img.getSizeX();
     m_height = img.getSizeY();
+    if (!gridFits(m_width, m_height))
+    {
+        throw std::length_error("image too large for the face index, build with TOS_WIDE_INDEX");
+    }
 
     VERBOSE(YELLOW << " - Extend image... ")
-    extend();
+    {
+        Profiler::Scope stage("extend");
+        extend(img);
+        stage.items(m_extended.size());
+    }
     VERBOSE(GREEN << "done.\n")
 
     VERBOSE(YELLOW << " - Image interpolation... ")
-    interpolate();
+    {
+        Profiler::Scope stage("interpolate");
+        interpolate();
+        stage.items(size());
+    }
     VERBOSE(GREEN << "done.\n"
                   << RESET)
 }
 
 template <typename T>
-void SVMImage<T>::extend()
+void SVMImage<T>::extend(const LibTIM::Image<T> &img)
 {
-    // compute meidan value of the image
-    std::vector<T> vec(m_original.begin(), m_original.end());
-
-    std::size_t size = vec.size() - 1;
     // we assume the image is not of size 0,0
-    std::sort(vec.begin(), vec.end());
-    T median;
-    if (size % 2 == 0)
-    {
-        median = (vec[size / 2] + vec[(size / 2) + 1]) / 2;
-    }
-    else
-    {
-        median = vec[size / 2];
-    }
+    T median = medianValue(img, SmallIntegral());
 
     // extends the image with the median value
-    LibTIM::TSize newSizeX = m_original.getSizeX() + 2;
-    LibTIM::TSize newSizeY = m_original.getSizeY() + 2;
+    std::size_t newSizeX = static_cast<std::size_t>(img.getSizeX()) + 2;
+    std::size_t newSizeY = static_cast<std::size_t>(img.getSizeY()) + 2;
 
-    std::vector<SVMCell<T> *> e_img;
+    Buffer<T> e_img(newSizeX * newSizeY);
 
-    for (LibTIM::TSize j = 0; j < newSizeY; ++j)
+    for (std::size_t j = 0; j < newSizeY; ++j)
     {
-        for (LibTIM::TSize i = 0; i < newSizeX; ++i)
+        for (std::size_t i = 0; i < newSizeX; ++i)
         {
             if (i <= 0 || i >= newSizeX - 1 || j <= 0 || j >= newSizeY - 1)
             {
-                e_img.push_back(new SVMCell<T>(CellType::Original, median));
+                e_img[j * newSizeX + i] = median;
             }
             else
             {
-                e_img.push_back(new SVMCell<T>(CellType::Original, m_original(i - 1, j - 1)));
+                e_img[j * newSizeX + i] = img(i - 1, j - 1);
             }
         }
     }
-    m_image = e_img;
-    m_width = newSizeX;
-    m_height = newSizeY;
+    m_extended.swap(e_img);
+    m_width = m_extWidth = newSizeX;
+    m_height = m_extHeight = newSizeY;
+
+    if (m_rank)
+    {
+        // the border is part of the extended image: the median keeps its order with the pixels
+        rankTransform(SmallIntegral());
+        VERBOSE("\n   + " << m_levels.size() << " levels\n")
+    }
+    m_maxValue = *std::max_element(m_extended.begin(), m_extended.end());
+}
+
+template <typename T>
+T SVMImage<T>::medianValue(const LibTIM::Image<T> &img, std::true_type) const
+{
+    // one pass histogram, no copy of the image
+    Buffer<std::size_t> histogram(static_cast<std::size_t>(std::numeric_limits<T>::max() - std::numeric_limits<T>::min()) + 1, 0);
+    for (auto it = img.begin(); it != img.end(); ++it)
+    {
+        histogram[static_cast<std::size_t>(*it - std::numeric_limits<T>::min())]++;
+    }
+
+    std::size_t n = img.getSizeX() * static_cast<std::size_t>(img.getSizeY());
+    std::size_t k = (n - 1) / 2;
+    bool average = (n - 1) % 2 == 0;
+
+    // values of rank k and k + 1
+    std::size_t seen = 0, bin = 0;
+    while (seen + histogram[bin] <= k)
+    {
+        seen += histogram[bin++];
+    }
+    T low = static_cast<T>(bin + std::numeric_limits<T>::min());
+    if (!average || n == 1)
+    {
+        return low;
+    }
+    if (seen + histogram[bin] <= k + 1)
+    {
+        bin++;
+        while (histogram[bin] == 0)
+        {
+            bin++;
+        }
+    }
+    T high = static_cast<T>(bin + std::numeric_limits<T>::min());
+    return (low + high) / 2;
+}
+
+template <typename T>
+T SVMImage<T>::medianValue(const LibTIM::Image<T> &img, std::false_type) const
+{
+    // selection in linear time
+    Buffer<T> vec(img.begin(), img.end());
+    std::size_t k = (vec.size() - 1) / 2;
+    bool average = (vec.size() - 1) % 2 == 0;
+
+    std::nth_element(vec.begin(), vec.begin() + k, vec.end());
+    T low = vec[k];
+    if (!average || vec.size() == 1)
+    {
+        return low;
+    }
+    T high = *std::min_element(vec.begin() + k + 1, vec.end());
+    return (low + high) / 2;
+}
+
+template <typename T>
+void SVMImage<T>::rankTransform(std::true_type)
+{
+    // rank of each value from a presence table over the range of T
+    Buffer<std::size_t> rank(static_cast<std::size_t>(std::numeric_limits<T>::max() - std::numeric_limits<T>::min()) + 1, 0);
+    for (auto v : m_extended)
+    {
+        rank[static_cast<std::size_t>(v - std::numeric_limits<T>::min())] = 1;
+    }
+    m_levels.clear();
+    for (std::size_t bin = 0; bin < rank.size(); bin++)
+    {
+        if (rank[bin])
+        {
+            rank[bin] = m_levels.size();
+            m_levels.push_back(static_cast<T>(bin + std::numeric_limits<T>::min()));
+        }
+    }
+
+    for (auto &v : m_extended)
+    {
+        v = static_cast<T>(rank[static_cast<std::size_t>(v - std::numeric_limits<T>::min())]);
+    }
+}
+
+template <typename T>
+void SVMImage<T>::rankTransform(std::false_type)
+{
+    Buffer<T> levels(m_extended);
+    std::sort(levels.begin(), levels.end());
+    levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+    levels.shrink_to_fit();
+    // the ranks are stored as T: a floating point type only holds the integers up to 2^digits exactly,
+    // above that neighbouring ranks would be merged into one level
+    if (!std::is_integral<T>::value && levels.size() - 1 > (std::size_t(1) << std::numeric_limits<T>::digits))
+    {
+        throw std::length_error("too many distinct values to rank them exactly in the type of the image");
+    }
+    m_levels.swap(levels);
+
+#pragma omp parallel for
+    for (std::size_t i = 0; i < m_extended.size(); i++)
+    {
+        m_extended[i] = static_cast<T>(std::lower_bound(m_levels.begin(), m_levels.end(), m_extended[i]) - m_levels.begin());
+    }
 }
 
 template <typename T>
@@ -73,20 +187,29 @@ void SVMImage<T>::interpolate()
 
     std::size_t nbCol = 2 * (n * 2 - 1) - 1;
     std::size_t nbLine = 2 * (m * 2 - 1) - 1;
-    std::size_t size = (nbCol * nbLine) - 1;
-    std::vector<SVMCell<T> *> i_img(size + 1);
+
+    if (m_implicit)
+    {
+        // cells are computed on demand, see implicitRange()
+        VERBOSE("   + implicit grid\n")
+        m_height = nbLine;
+        m_width = nbCol;
+        m_interpolated = true;
+        return;
+    }
+
+    std::size_t size = nbCol * nbLine;
+    Buffer<T> i_min(size);
+    Buffer<T> i_max(size);
 
     // fill old pixels
 #pragma omp parallel for
-    for (unsigned int l = 0; l < m_height; l++)
+    for (std::size_t l = 0; l < m_height; l++)
     {
-        for (unsigned int c = 0; c < m_width; c++)
+        for (std::size_t c = 0; c < m_width; c++)
         {
-            SVMCell<T> *cell = new SVMCell<T>(CellType::Original, m_image.at(l * m_width + c)->value());
-            cell->posX(c * 4);
-            cell->posY(l * 4);
-            cell->visited(false);
-            i_img.at((l * 4) * nbCol + (c * 4)) = cell;
+            std::size_t id = (l * 4) * nbCol + (c * 4);
+            i_min[id] = i_max[id] = m_extended[l * m_width + c];
         }
     }
     VERBOSE("   + old pixels\n")
@@ -97,42 +220,29 @@ void SVMImage<T>::interpolate()
     {
         for (std::size_t c = (l + 2) % 4; c < nbCol; c += 4)
         {
+            std::size_t id = l * nbCol + c;
             if (l % 4 == 2)
             {
                 // max of both neighboor original pixels on the same column
-                SVMCell<T> *cell = new SVMCell<T>(CellType::New, std::max(i_img.at((l - 2) * nbCol + c)->value(),
-                                                                          i_img.at((l + 2) * nbCol + c)->value()));
-                cell->posX(c);
-                cell->posY(l);
-                cell->visited(false);
-                i_img.at(l * nbCol + c) = cell;
+                i_min[id] = i_max[id] = std::max(i_min[id - 2 * nbCol], i_min[id + 2 * nbCol]);
             }
             else if (l % 4 == 0)
             {
                 // max of neighboor original pixel on the same line
-                SVMCell<T> *cell = new SVMCell<T>(CellType::New, std::max(i_img.at(l * nbCol + c - 2)->value(),
-                                                                          i_img.at(l * nbCol + c + 2)->value()));
-                cell->posX(c);
-                cell->posY(l);
-                cell->visited(false);
-                i_img.at(l * nbCol + c) = cell;
+                i_min[id] = i_max[id] = std::max(i_min[id - 2], i_min[id + 2]);
             }
         }
     }
 
     // fill the remaining values (arbitrary order)
 #pragma omp parallel for
-    for (unsigned int l = 2; l < nbLine; l += 4)
+    for (std::size_t l = 2; l < nbLine; l += 4)
     {
-        for (unsigned int c = 2; c < nbCol; c += 4)
+        for (std::size_t c = 2; c < nbCol; c += 4)
         {
-            T m = std::max(std::max(i_img.at((l - 2) * nbCol + c)->value(), i_img.at((l + 2) * nbCol + c)->value()),
-                           std::max(i_img.at(l * nbCol + c - 2)->value(), i_img.at(l * nbCol + c + 2)->value()));
-            SVMCell<T> *cell = new SVMCell<T>(CellType::New, m);
-            cell->posX(c);
-            cell->posY(l);
-            cell->visited(false);
-            i_img.at(l * nbCol + c) = cell;
+            std::size_t id = l * nbCol + c;
+            i_min[id] = i_max[id] = std::max(std::max(i_min[id - 2 * nbCol], i_min[id + 2 * nbCol]),
+                                             std::max(i_min[id - 2], i_min[id + 2]));
         }
     }
     VERBOSE("   + new pixels\n")
@@ -143,123 +253,176 @@ void SVMImage<T>::interpolate()
     {
         for (std::size_t c = (l + 1) % 2; c < nbCol; c += 2)
         {
+            std::size_t id = l * nbCol + c;
             if (l % 2 == 1)
             {
                 // max and min of both neighboor original or new pixels on the same column
-                T mi, ma;
-                T valU = i_img.at((l - 1) * nbCol + c)->value();
-                T valD = i_img.at((l + 1) * nbCol + c)->value();
-                if (valU < valD)
-                {
-                    mi = valU;
-                    ma = valD;
-                }
-                else
-                {
-                    mi = valD;
-                    ma = valU;
-                }
-                SVMCell<T> *cell = new SVMCell<T>(CellType::Inter2, mi, ma);
-                cell->posX(c);
-                cell->posY(l);
-                cell->visited(false);
-                i_img.at(l * nbCol + c) = cell;
+                T valU = i_min[id - nbCol];
+                T valD = i_min[id + nbCol];
+                i_min[id] = std::min(valU, valD);
+                i_max[id] = std::max(valU, valD);
             }
             else if (l % 2 == 0)
             {
                 // max and min of neighboor original or new pixel on the same line
-                std::size_t id = l * nbCol + c;
-                T mi, ma;
-                T valL = i_img.at(id - 1)->value();
-                T valR = i_img.at(id + 1)->value();
-                if (valL < valR)
-                {
-                    mi = valL;
-                    ma = valR;
-                }
-                else
-                {
-                    mi = valR;
-                    ma = valL;
-                }
-                SVMCell<T> *cell = new SVMCell<T>(CellType::Inter2, mi, ma);
-                cell->posX(c);
-                cell->posY(l);
-                cell->visited(false);
-                i_img.at(l * nbCol + c) = cell;
+                T valL = i_min[id - 1];
+                T valR = i_min[id + 1];
+                i_min[id] = std::min(valL, valR);
+                i_max[id] = std::max(valL, valR);
             }
         }
     }
 
     // arbitrary order
+    // span of the value ranges of the four Inter2 neighbours
 #pragma omp parallel for
-    for (unsigned int l = 1; l < nbLine; l += 2)
+    for (std::size_t l = 1; l < nbLine; l += 2)
     {
-        for (unsigned int c = 1; c < nbCol; c += 2)
+        for (std::size_t c = 1; c < nbCol; c += 2)
         {
-
-            T values[] = {i_img.at((l - 1) * nbCol + c)->value(),
-                          i_img.at((l + 1) * nbCol + c)->value(),
-                          i_img.at(l * nbCol + c - 1)->value(),
-                          i_img.at(l * nbCol + c + 1)->value()};
-            T mi = values[0];
-            T ma = mi;
-            for (std::size_t i = 1; i < 4; i++)
-            {
-                if (values[i] < mi)
-                {
-                    mi = values[i];
-                }
-                else if (values[i] > ma)
-                {
-                    ma = values[i];
-                }
-            }
-            SVMCell<T> *cell = new SVMCell<T>(CellType::Inter4, mi, ma);
-            cell->posX(c);
-            cell->posY(l);
-            cell->visited(false);
-            i_img.at(l * nbCol + c) = cell;
+            std::size_t id = l * nbCol + c;
+            i_min[id] = std::min(std::min(i_min[id - nbCol], i_min[id + nbCol]),
+                                 std::min(i_min[id - 1], i_min[id + 1]));
+            i_max[id] = std::max(std::max(i_max[id - nbCol], i_max[id + nbCol]),
+                                 std::max(i_max[id - 1], i_max[id + 1]));
         }
     }
     VERBOSE("   + interpixels\n")
 
-    m_image = i_img;
+    m_min.swap(i_min);
+    m_max.swap(i_max);
     m_height = nbLine;
     m_width = nbCol;
+    m_interpolated = true;
 }
 
 template <typename T>
 void SVMImage<T>::uninterpolate(TOS<T> *tree)
 {
-    // clean sortedPixel in tree to remove pointers to non-original cells
+    Profiler::Scope stage("uninterpolate");
+
+    // remap the tree on the Original cells only
     tree->clean();
 
-    // remove all non-original cells
-    m_image.erase(std::remove_if(m_image.begin(), m_image.end(), [](SVMCell<T> *cell) { return cell->type() != CellType::Original; }), m_image.end());
+    // the Original cells are the extended image: release the interpolated grid
+    Buffer<T>().swap(m_min);
+    Buffer<T>().swap(m_max);
+
+    m_width = m_extWidth;
+    m_height = m_extHeight;
+    m_interpolated = false;
+    stage.items(size());
+}
+
+template <typename T>
+FaceIndex SVMImage<T>::operator()(std::size_t i, std::size_t j) const
+{
+    return static_cast<FaceIndex>(m_width * j + i);
+}
+
+template <typename T>
+CellType SVMImage<T>::type(FaceIndex id) const
+{
+    if (!m_interpolated)
+    {
+        return CellType::Original;
+    }
+    return cellType(posX(id), posY(id));
+}
+
+template <typename T>
+T SVMImage<T>::value(FaceIndex id) const { return min(id); }
+
+template <typename T>
+T SVMImage<T>::min(FaceIndex id) const
+{
+    T mi, ma;
+    range(id, mi, ma);
+    return mi;
+}
+
+template <typename T>
+T SVMImage<T>::max(FaceIndex id) const
+{
+    T mi, ma;
+    range(id, mi, ma);
+    return ma;
+}
 
-    for (auto cell : m_image)
+template <typename T>
+void SVMImage<T>::range(FaceIndex id, T &min, T &max) const
+{
+    if (!m_min.empty())
+    {
+        min = m_min[id];
+        max = m_max[id];
+    }
+    else if (!m_interpolated)
     {
-        cell->posX(cell->posX() / 4);
-        cell->posY(cell->posY() / 4);
+        min = max = m_extended[id];
     }
+    else
+    {
+        implicitRange(posX(id), posY(id), min, max);
+    }
+}
 
-    m_width = m_original.getSizeX() + 2;
-    m_height = m_original.getSizeY() + 2;
+template <typename T>
+T SVMImage<T>::implicitValue(std::size_t x, std::size_t y) const
+{
+    // an Original cell is its pixel, a New cell is the max of the 2 or 4 Original cells around it
+    std::size_t x0 = x / 4, x1 = (x + 3) / 4;
+    std::size_t y0 = y / 4, y1 = (y + 3) / 4;
+    const T *line0 = &m_extended[y0 * m_extWidth];
+    const T *line1 = &m_extended[y1 * m_extWidth];
+    return std::max(std::max(line0[x0], line0[x1]), std::max(line1[x0], line1[x1]));
 }
 
 template <typename T>
-const std::vector<SVMCell<T> *> &SVMImage<T>::data() const
+void SVMImage<T>::implicitRange(std::size_t x, std::size_t y, T &min, T &max) const
 {
-    return m_image;
+    switch (cellType(x, y))
+    {
+    case CellType::Original:
+    case CellType::New:
+        min = max = implicitValue(x, y);
+        break;
+    case CellType::Inter2:
+    {
+        // min and max of both neighboor original or new pixels on the same line or column
+        T a = (x & 1) ? implicitValue(x - 1, y) : implicitValue(x, y - 1);
+        T b = (x & 1) ? implicitValue(x + 1, y) : implicitValue(x, y + 1);
+        min = std::min(a, b);
+        max = std::max(a, b);
+        break;
+    }
+    case CellType::Inter4:
+    {
+        // span of the four Inter2 neighbours, i.e. of the four diagonal Original or New cells
+        T ul = implicitValue(x - 1, y - 1), ur = implicitValue(x + 1, y - 1);
+        T dl = implicitValue(x - 1, y + 1), dr = implicitValue(x + 1, y + 1);
+        min = std::min(std::min(ul, ur), std::min(dl, dr));
+        max = std::max(std::max(ul, ur), std::max(dl, dr));
+        break;
+    }
+    }
 }
 
 template <typename T>
-SVMCell<T> *SVMImage<T>::operator()(std::size_t i, std::size_t j)
+T SVMImage<T>::maxValue() const { return m_maxValue; }
+template <typename T>
+T SVMImage<T>::levelValue(T level) const { return m_levels.empty() ? level : m_levels[static_cast<std::size_t>(level)]; }
+template <typename T>
+T SVMImage<T>::valueLevel(T value) const
 {
-    return m_image.at(m_width * j + i);
+    return m_levels.empty() ? value : static_cast<T>(std::lower_bound(m_levels.begin(), m_levels.end(), value) - m_levels.begin());
 }
 
+template <typename T>
+std::size_t SVMImage<T>::posX(FaceIndex id) const { return id % m_width; }
+template <typename T>
+std::size_t SVMImage<T>::posY(FaceIndex id) const { return id / m_width; }
+
 template <typename T>
 inline void SVMImage<T>::width(std::size_t w) { m_width = w; }
 template <typename T>
@@ -268,3 +431,11 @@ template <typename T>
 std::size_t SVMImage<T>::width() const { return m_width; }
 template <typename T>
 std::size_t SVMImage<T>::height() const { return m_height; }
+template <typename T>
+std::size_t SVMImage<T>::size() const { return m_width * m_height; }
+template <typename T>
+bool SVMImage<T>::interpolated() const { return m_interpolated; }
+template <typename T>
+bool SVMImage<T>::implicit() const { return m_implicit; }
+template <typename T>
+bool SVMImage<T>::ranked() const { return m_rank; }
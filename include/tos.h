@@ -1,33 +1,85 @@
 #ifndef TOS_H
 #define TOS_H
 
+#include "neighborhood.h"
 #include "pqueue.h"
 #include "svm_img.h"
+#include "tos_file.h"
 #include "utils.h"
 #include <SFML/Graphics.hpp>
+#include <ostream>
 #include <vector>
 
 template <typename T>
 class TOS
 {
 public:
-    TOS(SVMImage<T> &img);
+    // <nbTiles> > 1 computes the union-find on that many horizontal tiles in parallel,
+    // <connectivity> (4 or 8) is the neighbourhood of the cells of the interpolated grid: both give the same
+    // tree once uninterpolated, but not the same tree on the interpolated grid
+    TOS(SVMImage<T> &img, unsigned int nbTiles = 1, unsigned int connectivity = 8);
 
-    std::vector<SVMCell<T> *> sort();
+    Buffer<FaceIndex> sort();
     void unionFind();
     void canonize();
 
-    // remove pointers to non-origina cells
+    // remap the tree on Original cells only, in compact indices (those of the extended image),
+    // releasing the interpolated tree
     void clean();
 
-    // draw the parenting path
+    // read only access to the tree, in its canonical representation: the parent of a face is the
+    // canonical face of its node, the parent of a canonical face is the canonical face of the parent node
+    inline FaceIndex parent(FaceIndex id) const;
+    inline T level(FaceIndex id) const;
+    // faces sorted parents first, starting with the root
+    inline const Buffer<FaceIndex> &order() const;
+    // true if <id> is the canonical face of its node
+    inline bool isCanonical(FaceIndex id) const;
+    // parent of <id> in the canonical tree of the interpolated grid, where Original cells are linked
+    // like the other faces instead of being linked to Original cells for clean(); parent() once cleaned
+    inline FaceIndex canonicalParent(FaceIndex id) const;
+    // image whose cells are the faces of the tree
+    inline const SVMImage<T> &image() const;
+
+    // write the tree to a .tos file (see tos_file.h), with the levels as image values
+    bool save(const char *filename) const;
+    // write the same record to <out>: records can be concatenated on a stream
+    bool save(std::ostream &out) const;
+
+    // draw the parenting path, rebuilt only when the hovered cell changes
     void drawParents(sf::RenderWindow &window, const sf::Vector2f &pos);
 
 private:
-    SVMCell<T> *findRoot(SVMCell<T> *current);
+    // root of <current> in the zpar forest, halving the path on the way
+    inline FaceIndex findRoot(FaceIndex current);
+
+    // union-find on the cells [<begin>, <end>) of R, all in rows [<yBegin>, <yEnd>) and in the order of R
+    void unionFindRows(const FaceIndex *begin, const FaceIndex *end, std::size_t yBegin, std::size_t yEnd);
+    // merge the partial trees of the tiles on both sides of the border above row <y>
+    void mergeRows(std::size_t y, const Buffer<FaceIndex> &rank);
+    // merge the branches of <x> and <y> in the tree, <rank> being the position in sortedPixels
+    void connect(FaceIndex x, FaceIndex y, const Buffer<FaceIndex> &rank);
+    // first cell in R of the node of <current> (last ancestor at the same level), compressing the path
+    inline FaceIndex levelRoot(FaceIndex current);
 
     SVMImage<T> &m_image;
-    std::vector<SVMCell<T> *> sortedPixels; // R in the article
+    unsigned int m_nbTiles;
+    Neighborhood m_neighborhood;
+    Buffer<FaceIndex> sortedPixels; // R in the article
+
+    // tree data, indexed like the cells of m_image
+    Buffer<FaceIndex> m_parent;
+    Buffer<FaceIndex> m_zpar;
+    Buffer<FaceIndex> m_repr;     // for a zpar root, the root of its component in the tree
+    Buffer<unsigned char> m_rank; // union by rank of the zpar forest
+    Buffer<T> m_level; // memorization of the level where the queue handled the face
+    // canonical parent of the Original cells, indexed like the extended image (empty once cleaned)
+    Buffer<FaceIndex> m_originalParent;
+
+    // parenting path drawn for m_hovered: its centers, and the outlines of its cells as lines
+    FaceIndex m_hovered = NO_FACE;
+    std::vector<sf::Vertex> m_path;
+    std::vector<sf::Vertex> m_outlines;
 };
 
 #include "tos.hpp"
@@ -1,132 +1,270 @@
 #include "tos.h"
+#include <cstring>
+#include <fstream>
+#include <limits>
 
 template <typename T>
-TOS<T>::TOS(SVMImage<T> &img) : m_image(img)
+TOS<T>::TOS(SVMImage<T> &img, unsigned int nbTiles, unsigned int connectivity)
+    : m_image(img), m_nbTiles(nbTiles), m_neighborhood(img.width(), img.height(), connectivity)
 {
     VERBOSE(YELLOW << " - Sort pixels... ")
-    sortedPixels = sort();
+    {
+        Profiler::Scope stage("sort");
+        sortedPixels = sort();
+        stage.items(sortedPixels.size());
+    }
     VERBOSE(GREEN << "done\n")
 
     VERBOSE(YELLOW << " - Union find algorithm... ")
-    unionFind();
+    {
+        Profiler::Scope stage("unionFind");
+        unionFind();
+        stage.items(sortedPixels.size());
+    }
     VERBOSE(GREEN << "done.\n")
 
     VERBOSE(YELLOW << " - Canonize tree... ")
-    canonize();
+    {
+        Profiler::Scope stage("canonize");
+        canonize();
+        stage.items(sortedPixels.size());
+    }
     VERBOSE(GREEN << "done.\n")
 }
 
 template <typename T>
 void TOS<T>::unionFind()
 {
-    for (int i = sortedPixels.size() - 1; i >= 0; i--)
-    {
-        SVMCell<T> *currentP = sortedPixels[i];
-        currentP->parent(currentP);
-        currentP->zpar(currentP);
+    m_parent.assign(m_image.size(), NO_FACE);
+    m_zpar.assign(m_image.size(), NO_FACE);
+    m_repr.resize(m_image.size());
+    m_rank.assign(m_image.size(), 0);
 
-        std::vector<SVMCell<T> *> neighbours;
+    // at least two rows per tile
+    std::size_t nbTiles = std::max<std::size_t>(1, std::min<std::size_t>(m_nbTiles, m_image.height() / 2));
 
-        for (int j = currentP->posY() - 1; j <= currentP->posY() + 1; j++)
+    if (nbTiles == 1)
+    {
+        unionFindRows(sortedPixels.data(), sortedPixels.data() + sortedPixels.size(), 0, m_image.height());
+    }
+    else
+    {
+        std::size_t width = m_image.width();
+        std::vector<std::size_t> rowStart(nbTiles + 1);
+        std::vector<std::size_t> rowTile(m_image.height());
+        for (std::size_t t = 0; t <= nbTiles; t++)
         {
-            if (j < 0 || j >= m_image.height())
+            rowStart[t] = t * m_image.height() / nbTiles;
+            if (t > 0)
             {
-                continue;
+                std::fill(rowTile.begin() + rowStart[t - 1], rowTile.begin() + rowStart[t], t - 1);
             }
+        }
+
+        // R split by tile in one stable pass, each tile keeping the global processing order:
+        // every face is in R, so tile t starts at the first face of its rows
+        Buffer<FaceIndex> tiled(sortedPixels.size());
+        std::vector<std::size_t> next(nbTiles);
+        for (std::size_t t = 0; t < nbTiles; t++)
+        {
+            next[t] = rowStart[t] * width;
+        }
+        for (FaceIndex p : sortedPixels)
+        {
+            tiled[next[rowTile[p / width]]++] = p;
+        }
+
+        // partial trees of each tile
+#pragma omp parallel for num_threads(nbTiles) schedule(static, 1)
+        for (std::size_t t = 0; t < nbTiles; t++)
+        {
+            unionFindRows(tiled.data() + rowStart[t] * width, tiled.data() + rowStart[t + 1] * width, rowStart[t], rowStart[t + 1]);
+        }
+
+        // the tiled R is no longer needed, its memory holds the ranks
+        Buffer<FaceIndex> rank;
+        rank.swap(tiled);
+#pragma omp parallel for num_threads(nbTiles)
+        for (std::size_t i = 0; i < sortedPixels.size(); i++)
+        {
+            rank[sortedPixels[i]] = static_cast<FaceIndex>(i);
+        }
 
-            for (int k = currentP->posX() - 1; k <= currentP->posX() + 1; k++)
+        // merge neighbour tiles two by two: each merge only touches the cells of the two merged groups
+        for (std::size_t step = 1; step < nbTiles; step *= 2)
+        {
+#pragma omp parallel for num_threads(nbTiles) schedule(dynamic, 1)
+            for (std::size_t t = step; t < nbTiles; t += 2 * step)
             {
-                if ((j != currentP->posY() || k != currentP->posX()) && k >= 0 && k < m_image.width())
-                {
-                    neighbours.push_back(m_image(k, j));
-                }
+                mergeRows(rowStart[t], rank);
             }
         }
+    }
 
-        for (auto neighbour : neighbours)
-        {
-            if (neighbour->zpar() != nullptr)
+    // zpar is only needed while building the tree
+    Buffer<FaceIndex>().swap(m_zpar);
+    Buffer<FaceIndex>().swap(m_repr);
+    Buffer<unsigned char>().swap(m_rank);
+}
+
+template <typename T>
+void TOS<T>::unionFindRows(const FaceIndex *begin, const FaceIndex *end, std::size_t yBegin, std::size_t yEnd)
+{
+    std::size_t width = m_image.width();
+
+    for (const FaceIndex *it = end; it != begin;)
+    {
+        FaceIndex currentP = *--it;
+        m_parent[currentP] = currentP;
+        m_zpar[currentP] = currentP;
+        m_repr[currentP] = currentP;
+        FaceIndex zp = currentP; // root of the component of currentP in the zpar forest
+
+        std::size_t y = currentP / width;
+        std::size_t x = currentP - y * width;
+
+        m_neighborhood.forEach(currentP, x, y, yBegin, yEnd, [&](FaceIndex neighbour) {
+            if (m_zpar[neighbour] != NO_FACE)
             {
-                SVMCell<T> *root = findRoot(neighbour);
-                if (root != currentP)
+                FaceIndex root = findRoot(neighbour);
+                if (root != zp)
                 {
-                    root->parent(currentP);
-                    root->zpar(currentP);
+                    // the tree is linked under currentP, the zpar forest is linked by rank
+                    m_parent[m_repr[root]] = currentP;
+                    if (m_rank[zp] < m_rank[root])
+                    {
+                        std::swap(zp, root);
+                    }
+                    else if (m_rank[zp] == m_rank[root])
+                    {
+                        m_rank[zp]++;
+                    }
+                    m_zpar[root] = zp;
+                    m_repr[zp] = currentP;
                 }
             }
+        });
+    }
+}
+
+template <typename T>
+void TOS<T>::mergeRows(std::size_t y, const Buffer<FaceIndex> &rank)
+{
+    // links from the cells of row y - 1 to their neighbours of row y
+    FaceIndex first = m_image(0, y);
+    for (std::size_t x = 0; x < m_image.width(); x++)
+    {
+        FaceIndex p = m_image(x, y - 1);
+        m_neighborhood.forEach(p, x, y - 1, y - 1, y + 1, [&](FaceIndex n) {
+            if (n >= first)
+            {
+                connect(p, n, rank);
+            }
+        });
+    }
+}
+
+template <typename T>
+void TOS<T>::connect(FaceIndex x, FaceIndex y, const Buffer<FaceIndex> &rank)
+{
+    // A parent is always processed before its children, so the two branches are merged like two
+    // sorted lists (Wilkinson et al., concurrent computation of attribute filters). The lists are
+    // walked node by node, each node being its level root: a flat zone is one chain of cells.
+    x = levelRoot(x);
+    y = levelRoot(y);
+    if (rank[x] < rank[y])
+    {
+        std::swap(x, y);
+    }
+    // x is now the deepest one
+    while (x != y && y != NO_FACE)
+    {
+        FaceIndex z = m_parent[x] == x ? NO_FACE : levelRoot(m_parent[x]);
+        if (z != NO_FACE && rank[z] >= rank[y])
+        {
+            x = z;
+        }
+        else
+        {
+            // at the same level, the two nodes become one, canonize() picks its first cell
+            m_parent[x] = y;
+            x = y;
+            y = z;
         }
     }
 }
+
 template <typename T>
-SVMCell<T> *TOS<T>::findRoot(SVMCell<T> *current)
+FaceIndex TOS<T>::levelRoot(FaceIndex current)
 {
-    if (current->zpar() == current)
+    FaceIndex root = current;
+    while (m_parent[root] != root && m_level[m_parent[root]] == m_level[root])
     {
-        return current;
+        root = m_parent[root];
     }
-    else
+    // the cells of the chain are linked to its first cell, still processed before them
+    while (current != root)
     {
-        current->zpar(findRoot(current->zpar()));
-        return current->zpar();
+        FaceIndex next = m_parent[current];
+        m_parent[current] = root;
+        current = next;
     }
+    return root;
 }
 
 template <typename T>
-std::vector<SVMCell<T> *> TOS<T>::sort()
+FaceIndex TOS<T>::findRoot(FaceIndex current)
 {
-    PQueue<T> q;
-    std::vector<SVMCell<T> *> order;
+    while (m_zpar[current] != current)
+    {
+        m_zpar[current] = m_zpar[m_zpar[current]];
+        current = m_zpar[current];
+    }
+    return current;
+}
+
+template <typename T>
+Buffer<FaceIndex> TOS<T>::sort()
+{
+    // one bucket per level actually present, not per value of T
+    PQueue<T> q(static_cast<std::size_t>(m_image.maxValue()) + 1);
+    Buffer<FaceIndex> order;
+    order.reserve(m_image.size());
 
-    std::vector<SVMCell<T> *> neighbours;
-    SVMCell<T> *n;
+    m_level.resize(m_image.size());
+    Buffer<bool> visited(m_image.size(), false);
 
     // get first level
-    SVMCell<T> *borderFace = m_image(0, 0); // p_infinite
-    T borderValue = borderFace->value();    // l_infinite
+    FaceIndex borderFace = m_image(0, 0);        // p_infinite
+    T borderValue = m_image.value(borderFace); // l_infinite
     std::size_t initialLevel = static_cast<std::size_t>(borderValue);
 
     std::size_t l = initialLevel;
+    std::size_t width = m_image.width();
 
     q.push(borderFace, borderValue);
+    visited[borderFace] = true;
 
     while (!q.empty())
     {
-        SVMCell<T> *currentFace = q.priority_pop(&l); // h
+        FaceIndex currentFace = q.priority_pop(&l); // h
 
-        currentFace->visited(true);
-        currentFace->level(l);
+        m_level[currentFace] = static_cast<T>(l);
         order.push_back(currentFace);
 
-        // get neighbours
-        for (int j = currentFace->posY() - 1; j <= currentFace->posY() + 1; j++)
-        {
-            if (j < 0 || j >= m_image.height())
-            {
-                continue;
-            }
+        std::size_t y = currentFace / width;
+        std::size_t x = currentFace - y * width;
 
-            for (int k = currentFace->posX() - 1; k <= currentFace->posX() + 1; k++)
+        // add neighbourhood to queue
+        m_neighborhood.forEach(currentFace, x, y, [&](FaceIndex n) {
+            if (!visited[n])
             {
-                if ((j != currentFace->posY() || k != currentFace->posX()) && k >= 0 && k < m_image.width())
-                {
-
-                    n = m_image(k, j);
-
-                    if (!n->visited())
-                    {
-                        neighbours.push_back(n);
-                    }
-                }
+                T mi, ma;
+                m_image.range(n, mi, ma);
+                q.priority_push(n, mi, ma, l);
+                visited[n] = true;
             }
-        }
-
-        // add neighbourhood to queue
-        for (unsigned int j = 0; j < neighbours.size(); j++)
-        {
-            q.priority_push(neighbours[j], l);
-            neighbours[j]->visited(true);
-        }
-        neighbours.clear();
+        });
     }
 
     return order;
@@ -135,92 +273,69 @@ std::vector<SVMCell<T> *> TOS<T>::sort()
 template <typename T>
 void TOS<T>::canonize()
 {
-    // for all p in [R in reverse order]
-    for (long int i = sortedPixels.size() - 1; i >= 0; i--)
-    {
-        // the pixel for which we are looking for a canonical parent
-        SVMCell<T> *p = sortedPixels[i];
-
-        // q <- parent(p)
-        SVMCell<T> *q = p->parent();
+    // the canonical cell of a node is its first cell in R, and its parent is the canonical cell of the parent node
+    auto isCanonical = [this](FaceIndex p) { return m_parent[p] == p || m_level[m_parent[p]] != m_level[p]; };
 
-        // we check that the parent pixel is of Original type
-        // if it is not the case -> we go through its parents
-        // until we get to a pixel of Original type
-        while (q->parent()->type() != CellType::Original)
+    // for all p in [R], parents first: link p to the canonical cell of its node
+    for (std::size_t i = 0; i < sortedPixels.size(); i++)
+    {
+        FaceIndex p = sortedPixels[i];
+        FaceIndex q = m_parent[p];
+        if (m_level[m_parent[q]] == m_level[q])
         {
-            q->parent(q->parent()->parent());
+            m_parent[p] = m_parent[q];
         }
+    }
 
-        // we check that the pixel and its parent belong to the same shape
-        if (q->level() == p->level())
+    // keep the canonical parent of the Original cells before they are linked to the representatives
+    std::size_t gridWidth = m_image.width();
+    std::size_t width = (gridWidth + 3) / 4;
+    m_originalParent.resize(width * ((m_image.height() + 3) / 4));
+    for (std::size_t y = 0; y < m_image.height(); y += 4)
+    {
+        for (std::size_t x = 0; x < gridWidth; x += 4)
         {
-            // we save the path we made to find the canonical pixel
-            std::vector<SVMCell<T> *> qSave;
-            qSave.push_back(q);
+            m_originalParent[(y / 4) * width + x / 4] = m_parent[y * gridWidth + x];
+        }
+    }
 
-            // if the pixel and its parent are in the same shape
-            // and if the pixel and its parent aren't the SAME pixel
-            while (q->parent()->level() == q->level() && q->parent() != q) // See svm_cell.h
-            {
-                // we continue through its parents
-                q = q->parent();
-                qSave.push_back(q);
-            }
+    // representative of each node: its first Original cell, or for a node without Original
+    // cell, the representative of the closest ancestor having one (the root is an Original cell)
+    Buffer<FaceIndex> repr(m_image.size(), NO_FACE);
+    for (std::size_t i = 0; i < sortedPixels.size(); i++)
+    {
+        FaceIndex p = sortedPixels[i];
+        FaceIndex node = isCanonical(p) ? p : m_parent[p];
+        if (repr[node] == NO_FACE && m_image.type(p) == CellType::Original)
+        {
+            repr[node] = p;
+        }
+    }
+    for (std::size_t i = 0; i < sortedPixels.size(); i++)
+    {
+        FaceIndex p = sortedPixels[i];
+        if (isCanonical(p) && repr[p] == NO_FACE)
+        {
+            repr[p] = repr[m_parent[p]];
+        }
+    }
 
-            // if the pixel and its parent are the same pixel
-            if (q->parent() == q)
-            {
-                // if it is of Original type, we can consider
-                // it is the parent we were looking for
-                if (q->parent()->type() == CellType::Original)
-                {
-                    // it is now the parent of the current pixel
-                    p->parent(q->parent());
-#pragma omp parallel for
-                    // and the parent of the pixels we went through
-                    for (unsigned int j = 0; j < qSave.size(); j++)
-                    {
-                        qSave[j]->parent(q->parent());
-                    }
-                }
-                // otherwise, the pixel and its parent are not in the same shape anymore
-            }
-            else if (q->parent()->level() != q->level())
-            {
-                // if the pixel is of Original type
-                if (q->parent()->type() == CellType::Original)
-                {
-                    p->parent(q->parent());
-#pragma omp parallel for
-                    for (unsigned int j = 0; j < qSave.size(); j++)
-                    {
-                        qSave[j]->parent(q->parent());
-                    }
-                }
-                else
-                {
-                    // otherwise we go through its parents
-                    // until we get to an Original pixel
-                    // and we take this one as a parent
-                    while (q->parent()->type() != CellType::Original)
-                    {
-                        q->parent(q->parent()->parent());
-                    }
-                    p->parent(q->parent());
-#pragma omp parallel for
-                    for (unsigned int j = 0; j < qSave.size(); j++)
-                    {
-                        qSave[j]->parent(q->parent());
-                    }
-                }
-            }
-            // otherwise the pixel and its parent are not in the same shape anymore
-            // we simply set the parent
+    // Original cells are linked to the representative of their node, or of the parent node for the representative itself
+    for (std::size_t i = 0; i < sortedPixels.size(); i++)
+    {
+        FaceIndex p = sortedPixels[i];
+        if (m_image.type(p) != CellType::Original)
+        {
+            continue;
         }
-        else
+        FaceIndex node = isCanonical(p) ? p : m_parent[p];
+        if (repr[node] != p)
         {
-            p->parent(q->parent());
+            m_parent[p] = repr[node];
+        }
+        else if (m_parent[node] != node)
+        {
+            m_parent[p] = repr[m_parent[node]];
         }
     }
 }
@@ -228,7 +343,139 @@ void TOS<T>::canonize()
 template <typename T>
 void TOS<T>::clean()
 {
-    sortedPixels.erase(std::remove_if(sortedPixels.begin(), sortedPixels.end(), [](SVMCell<T> *cell) { return cell->type() != CellType::Original; }), sortedPixels.end());
+    // Original cells are every 4 cells of the interpolated grid
+    std::size_t gridWidth = m_image.width();
+    std::size_t width = (m_image.width() + 3) / 4;
+    std::size_t height = (m_image.height() + 3) / 4;
+    auto compact = [gridWidth, width](FaceIndex id) {
+        std::size_t y = id / gridWidth;
+        std::size_t x = id - y * gridWidth;
+        return static_cast<FaceIndex>((y / 4) * width + x / 4);
+    };
+
+    Buffer<FaceIndex> parent(width * height);
+    Buffer<T> level(width * height);
+    Buffer<FaceIndex> order;
+    order.reserve(width * height);
+
+    // single pass over R: the parent of an Original cell is an Original cell (see canonize()),
+    // and R restricted to the Original cells still has the parents first
+    for (FaceIndex cell : sortedPixels)
+    {
+        std::size_t y = cell / gridWidth;
+        std::size_t x = cell - y * gridWidth;
+        if ((x & 3) != 0 || (y & 3) != 0)
+        {
+            continue;
+        }
+        FaceIndex id = static_cast<FaceIndex>((y / 4) * width + x / 4);
+        parent[id] = compact(m_parent[cell]);
+        level[id] = m_level[cell];
+        order.push_back(id);
+    }
+
+    // the interpolated tree is released with the local vectors
+    Buffer<FaceIndex>().swap(m_originalParent);
+    m_hovered = NO_FACE;
+    m_parent.swap(parent);
+    m_level.swap(level);
+    sortedPixels.swap(order);
+}
+
+template <typename T>
+FaceIndex TOS<T>::parent(FaceIndex id) const { return m_parent[id]; }
+template <typename T>
+T TOS<T>::level(FaceIndex id) const { return m_level[id]; }
+template <typename T>
+const Buffer<FaceIndex> &TOS<T>::order() const { return sortedPixels; }
+template <typename T>
+bool TOS<T>::isCanonical(FaceIndex id) const { return m_parent[id] == id || m_level[m_parent[id]] != m_level[id]; }
+template <typename T>
+FaceIndex TOS<T>::canonicalParent(FaceIndex id) const
+{
+    if (m_originalParent.empty())
+    {
+        return m_parent[id];
+    }
+    std::size_t gridWidth = m_image.width();
+    std::size_t y = id / gridWidth;
+    std::size_t x = id - y * gridWidth;
+    if ((x & 3) != 0 || (y & 3) != 0)
+    {
+        return m_parent[id];
+    }
+    return m_originalParent[(y / 4) * ((gridWidth + 3) / 4) + x / 4];
+}
+template <typename T>
+const SVMImage<T> &TOS<T>::image() const { return m_image; }
+
+template <typename T>
+bool TOS<T>::save(const char *filename) const
+{
+    std::ofstream file(filename, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    if (!file || !save(file))
+    {
+        std::cerr << "Tree file I/O error: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool TOS<T>::save(std::ostream &out) const
+{
+    Profiler::Scope stage("export");
+    stage.items(m_parent.size());
+
+    auto align = [](std::uint64_t offset) { return (offset + 7) & ~std::uint64_t(7); };
+
+    // the header stores the dimensions on 32 bits
+    if (m_image.width() > std::numeric_limits<std::uint32_t>::max() || m_image.height() > std::numeric_limits<std::uint32_t>::max())
+    {
+        std::cerr << "Error: " << m_image.width() << "x" << m_image.height() << " grid too large for the tree file header" << std::endl;
+        return false;
+    }
+
+    TOSFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TOS_FILE_MAGIC, sizeof(TOS_FILE_MAGIC));
+    header.version = TOS_FILE_VERSION;
+    header.width = static_cast<std::uint32_t>(m_image.width());
+    header.height = static_cast<std::uint32_t>(m_image.height());
+    header.interpolated = m_image.interpolated() ? 1 : 0;
+    header.levelType = TOSLevelTypeOf<T>::value;
+    header.size = m_parent.size();
+    header.orderSize = sortedPixels.size();
+    header.parentOffset = align(sizeof(header));
+    header.orderOffset = align(header.parentOffset + header.size * sizeof(FaceIndex));
+    header.levelOffset = align(header.orderOffset + header.orderSize * sizeof(FaceIndex));
+    header.indexSize = sizeof(FaceIndex);
+
+    // levels are written as image values, through the table of the rank transform if any
+    Buffer<T> levels(m_level.size());
+    for (std::size_t i = 0; i < m_level.size(); i++)
+    {
+        levels[i] = m_image.levelValue(m_level[i]);
+    }
+
+    // offsets are counted here rather than with tellp(), which fails on pipes
+    std::uint64_t written = 0;
+    auto write = [&out, &written](const void *data, std::uint64_t length) {
+        out.write(static_cast<const char *>(data), length);
+        written += length;
+    };
+    const char padding[8] = {0};
+    auto pad = [&write, &written, &padding](std::uint64_t offset) { write(padding, offset - written); };
+
+    write(&header, sizeof(header));
+    pad(header.parentOffset);
+    write(m_parent.data(), header.size * sizeof(FaceIndex));
+    pad(header.orderOffset);
+    write(sortedPixels.data(), header.orderSize * sizeof(FaceIndex));
+    pad(header.levelOffset);
+    write(levels.data(), header.size * sizeof(T));
+
+    return static_cast<bool>(out);
 }
 
 template <typename T>
@@ -236,33 +483,37 @@ void TOS<T>::drawParents(sf::RenderWindow &window, const sf::Vector2f &pos)
 {
     if (pos.x > 0 && pos.x < m_image.width() && pos.y > 0 && pos.y < m_image.height())
     {
-        std::vector<sf::Vertex> path;
-        sf::Vertex square[5];
+        FaceIndex cell = m_image(static_cast<std::size_t>(pos.x), static_cast<std::size_t>(pos.y));
+        if (cell != m_hovered)
+        {
+            // the same cell is hovered for many frames: walk its ancestors once
+            m_hovered = cell;
+            m_path.clear();
+            m_outlines.clear();
+            auto outline = [this](FaceIndex face) {
+                float x = m_image.posX(face);
+                float y = m_image.posY(face);
+                sf::Color col = typeToColor(m_image.type(face));
+                sf::Vector2f corners[4] = {{x, y}, {x + 1, y}, {x + 1, y + 1}, {x, y + 1}};
+                for (int i = 0; i < 4; i++)
+                {
+                    m_outlines.push_back(sf::Vertex(corners[i], col));
+                    m_outlines.push_back(sf::Vertex(corners[(i + 1) % 4], col));
+                }
+            };
 
-        SVMCell<T> *cell = m_image(static_cast<std::size_t>(pos.x), static_cast<std::size_t>(pos.y));
-        SVMCell<T> *current = cell;
+            FaceIndex current = cell;
+            do
+            {
+                float x = m_image.posX(current);
+                float y = m_image.posY(current);
+                m_path.push_back(sf::Vertex(sf::Vector2f(x + 0.5f, y + 0.5f), typeToColor(m_image.type(current))));
+                outline(current);
+                current = m_parent[current];
+            } while (m_parent[current] != current);
+        }
 
-        do
-        {
-            path.push_back(sf::Vertex(sf::Vector2f(current->posX() + 0.5f, current->posY() + 0.5f), typeToColor(current->type())));
-            sf::Color col = typeToColor(current->type());
-            square[0] = sf::Vertex(sf::Vector2f(current->posX(), current->posY()), col);
-            square[1] = sf::Vertex(sf::Vector2f(current->posX() + 1, current->posY()), col);
-            square[2] = sf::Vertex(sf::Vector2f(current->posX() + 1, current->posY() + 1), col);
-            square[3] = sf::Vertex(sf::Vector2f(current->posX(), current->posY() + 1), col);
-            square[4] = square[0];
-            window.draw(square, 5, sf::LinesStrip);
-            current = current->parent();
-        } while (current->parent() != current);
-
-        sf::Color col = typeToColor(cell->type());
-        square[0] = sf::Vertex(sf::Vector2f(cell->posX(), cell->posY()), col);
-        square[1] = sf::Vertex(sf::Vector2f(cell->posX() + 1, cell->posY()), col);
-        square[2] = sf::Vertex(sf::Vector2f(cell->posX() + 1, cell->posY() + 1), col);
-        square[3] = sf::Vertex(sf::Vector2f(cell->posX(), cell->posY() + 1), col);
-        square[4] = square[0];
-
-        window.draw(path.data(), path.size(), sf::LinesStrip);
-        window.draw(square, 5, sf::LinesStrip);
+        window.draw(m_outlines.data(), m_outlines.size(), sf::Lines);
+        window.draw(m_path.data(), m_path.size(), sf::LinesStrip);
     }
 }
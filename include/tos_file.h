@@ -0,0 +1,99 @@
+#ifndef TOS_FILE_H
+#define TOS_FILE_H
+
+#include "svm_cell.h"
+#include <cstddef>
+#include <cstdint>
+
+// Binary tree file (.tos): a fixed header followed by three arrays, all in host byte order
+//   parent[size] (face index), order[orderSize] (face index), level[size] (level type)
+// Each array starts at the offset given by the header, aligned on 8 bytes, so that a mapped
+// file can be read in place. Face indices are 32-bit, or 64-bit with TOS_WIDE_INDEX (version 2
+// header field indexSize; version 1 files have no such field and 32-bit indices).
+static const char TOS_FILE_MAGIC[4] = {'T', 'O', 'S', 'F'};
+static const std::uint32_t TOS_FILE_VERSION = 2;
+
+// type of the levels stored in the file
+enum TOSLevelType
+{
+    LevelU8 = 1,
+    LevelU16 = 2,
+    LevelU32 = 3,
+    LevelFloat = 4,
+    LevelDouble = 5
+};
+
+template <typename T>
+struct TOSLevelTypeOf;
+template <>
+struct TOSLevelTypeOf<std::uint8_t> { static const std::uint32_t value = LevelU8; };
+template <>
+struct TOSLevelTypeOf<std::uint16_t> { static const std::uint32_t value = LevelU16; };
+template <>
+struct TOSLevelTypeOf<std::uint32_t> { static const std::uint32_t value = LevelU32; };
+template <>
+struct TOSLevelTypeOf<float> { static const std::uint32_t value = LevelFloat; };
+template <>
+struct TOSLevelTypeOf<double> { static const std::uint32_t value = LevelDouble; };
+
+struct TOSFileHeader
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t width;        // faces are indexed row major, id = y * width + x
+    std::uint32_t height;
+    std::uint32_t interpolated; // 1 if the faces are the cells of the interpolated grid
+    std::uint32_t levelType;    // a TOSLevelType
+    std::uint64_t size;         // number of faces
+    std::uint64_t orderSize;    // number of faces in the processing order
+    std::uint64_t parentOffset; // offsets of the arrays from the beginning of the file
+    std::uint64_t orderOffset;
+    std::uint64_t levelOffset;
+    std::uint32_t indexSize;    // bytes per face index, since version 2
+    std::uint32_t reserved;
+};
+
+// Read only view of a .tos file, mapped in memory: the queries read the file in place.
+template <typename T>
+class TOSFile
+{
+public:
+    TOSFile();
+    ~TOSFile();
+    TOSFile(const TOSFile &) = delete;
+    TOSFile &operator=(const TOSFile &) = delete;
+
+    // map <filename>, false if it is not a valid tree file with levels of type T: the arrays must fit in
+    // the file and every parent and order entry must be a face of the tree
+    bool open(const char *filename);
+    void close();
+    inline bool isOpen() const;
+
+    inline std::size_t width() const;
+    inline std::size_t height() const;
+    inline std::size_t size() const;
+    inline bool interpolated() const;
+
+    inline FaceIndex parent(FaceIndex id) const;
+    inline T level(FaceIndex id) const;
+    // processing order, parents before children
+    inline const FaceIndex *order() const;
+    inline std::size_t orderSize() const;
+
+    inline FaceIndex root() const;
+    inline bool isRoot(FaceIndex id) const;
+    // true if <id> is the canonical face of its node
+    inline bool isCanonical(FaceIndex id) const;
+
+private:
+    void *m_data;
+    std::size_t m_length;
+    const TOSFileHeader *m_header;
+    const FaceIndex *m_parent;
+    const FaceIndex *m_order;
+    const T *m_level;
+};
+
+#include "tos_file.hpp"
+
+#endif // TOS_FILE_H
@@ -0,0 +1,163 @@
+#include "tos_file.h"
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+template <typename T>
+TOSFile<T>::TOSFile() : m_data(nullptr), m_length(0), m_header(nullptr), m_parent(nullptr), m_order(nullptr), m_level(nullptr)
+{
+}
+
+template <typename T>
+TOSFile<T>::~TOSFile()
+{
+    close();
+}
+
+template <typename T>
+bool TOSFile<T>::open(const char *filename)
+{
+    close();
+
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Tree file I/O error: " << filename << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < offsetof(TOSFileHeader, indexSize))
+    {
+        std::cerr << "Error: " << filename << " is not a tree file" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    m_length = st.st_size;
+    m_data = mmap(nullptr, m_length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (m_data == MAP_FAILED)
+    {
+        std::cerr << "Tree file I/O error: " << filename << std::endl;
+        m_data = nullptr;
+        return false;
+    }
+
+    const TOSFileHeader *header = static_cast<const TOSFileHeader *>(m_data);
+    if (std::memcmp(header->magic, TOS_FILE_MAGIC, sizeof(TOS_FILE_MAGIC)) != 0 || header->version < 1 ||
+        header->version > TOS_FILE_VERSION)
+    {
+        std::cerr << "Error: " << filename << " is not a tree file of version 1 to " << TOS_FILE_VERSION << std::endl;
+        close();
+        return false;
+    }
+    if (header->version >= 2 && m_length < sizeof(TOSFileHeader))
+    {
+        std::cerr << "Error: " << filename << " is truncated" << std::endl;
+        close();
+        return false;
+    }
+    std::uint32_t indexSize = header->version >= 2 ? header->indexSize : 4;
+    if (indexSize != sizeof(FaceIndex))
+    {
+        std::cerr << "Error: " << filename << " has " << 8 * indexSize << "-bit face indices, "
+                  << (indexSize > sizeof(FaceIndex) ? "build with" : "build without") << " TOS_WIDE_INDEX to read it" << std::endl;
+        close();
+        return false;
+    }
+    if (header->levelType != TOSLevelTypeOf<T>::value)
+    {
+        std::cerr << "Error: level type mismatch in " << filename << std::endl;
+        close();
+        return false;
+    }
+    // <count> elements of <bytes> bytes at <offset> are in the file, aligned for in place reads
+    // (written without products or sums that a crafted header could overflow)
+    std::uint64_t length = m_length;
+    auto inFile = [length](std::uint64_t offset, std::uint64_t count, std::uint64_t bytes) {
+        return offset % bytes == 0 && offset <= length && count <= (length - offset) / bytes;
+    };
+    if (header->size != static_cast<std::uint64_t>(header->width) * header->height ||
+        !inFile(header->parentOffset, header->size, sizeof(FaceIndex)) ||
+        !inFile(header->orderOffset, header->orderSize, sizeof(FaceIndex)) ||
+        !inFile(header->levelOffset, header->size, sizeof(T)))
+    {
+        std::cerr << "Error: " << filename << " is truncated" << std::endl;
+        close();
+        return false;
+    }
+
+    const char *bytes = static_cast<const char *>(m_data);
+    const FaceIndex *parent = reinterpret_cast<const FaceIndex *>(bytes + header->parentOffset);
+    const FaceIndex *order = reinterpret_cast<const FaceIndex *>(bytes + header->orderOffset);
+
+    // every face index read from the file is checked once here, so that the queries need no check
+    bool valid = header->orderSize > 0 && header->orderSize <= header->size && header->size <= static_cast<std::uint64_t>(NO_FACE);
+    for (std::uint64_t i = 0; valid && i < header->size; i++)
+    {
+        valid = parent[i] < header->size;
+    }
+    for (std::uint64_t i = 0; valid && i < header->orderSize; i++)
+    {
+        valid = order[i] < header->size;
+    }
+    if (!valid)
+    {
+        std::cerr << "Error: " << filename << " is corrupt" << std::endl;
+        close();
+        return false;
+    }
+
+    m_header = header;
+    m_parent = parent;
+    m_order = order;
+    m_level = reinterpret_cast<const T *>(bytes + header->levelOffset);
+    return true;
+}
+
+template <typename T>
+void TOSFile<T>::close()
+{
+    if (m_data)
+    {
+        munmap(m_data, m_length);
+    }
+    m_data = nullptr;
+    m_length = 0;
+    m_header = nullptr;
+    m_parent = m_order = nullptr;
+    m_level = nullptr;
+}
+
+template <typename T>
+bool TOSFile<T>::isOpen() const { return m_header != nullptr; }
+template <typename T>
+std::size_t TOSFile<T>::width() const { return m_header->width; }
+template <typename T>
+std::size_t TOSFile<T>::height() const { return m_header->height; }
+template <typename T>
+std::size_t TOSFile<T>::size() const { return m_header->size; }
+template <typename T>
+bool TOSFile<T>::interpolated() const { return m_header->interpolated != 0; }
+
+template <typename T>
+FaceIndex TOSFile<T>::parent(FaceIndex id) const { return m_parent[id]; }
+template <typename T>
+T TOSFile<T>::level(FaceIndex id) const { return m_level[id]; }
+template <typename T>
+const FaceIndex *TOSFile<T>::order() const { return m_order; }
+template <typename T>
+std::size_t TOSFile<T>::orderSize() const { return m_header->orderSize; }
+
+template <typename T>
+FaceIndex TOSFile<T>::root() const { return m_order[0]; }
+template <typename T>
+bool TOSFile<T>::isRoot(FaceIndex id) const { return m_parent[id] == id; }
+template <typename T>
+bool TOSFile<T>::isCanonical(FaceIndex id) const
+{
+    return isRoot(id) || m_level[m_parent[id]] != m_level[id];
+}
@@ -14,12 +14,11 @@ static bool verbose = false;
 #define BOLD_ON "\033[1m"
 #define BOLD_OFF "\033[21m"
 
-#define VERBOSE(str)      \
-    if (verbose)          \
-    {                     \
-        std::cout << str; \
-    }                     \
-    std::cout.flush();
+#define VERBOSE(str)                    \
+    if (verbose)                        \
+    {                                   \
+        std::cout << str << std::flush; \
+    }
 
 sf::Color typeToColor(CellType type)
 {
@@ -78,7 +78,7 @@ inline void FlatSE::setContext(const TSize *imSize)
 	std::vector<Point<TCoord> >::iterator end=points.end();
 	for(it=points.begin(); it!=end; ++it)
 	{
-		int offset = it->x + (it->y)*imSize[0] + (it->z)*imSize[0]*imSize[1];
+		TOffset offset = it->x + (TOffset)(it->y)*imSize[0] + (TOffset)(it->z)*imSize[0]*imSize[1];
 		offsets.push_back(offset);
 	}
 }
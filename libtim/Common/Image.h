@@ -104,6 +104,16 @@ class Image
 	TSize size [3];
 	TSpacing spacing [3];
 	TOffset dataSize;
+	///False when data is an external buffer, see setView()
+	bool ownsData = true;
+
+	///Delete the buffer if the image owns it
+	void releaseData()
+		{
+		if(this->data!=0 && ownsData) delete[] this->data;
+		this->data=0;
+		ownsData=true;
+		}
 
 public:
 
@@ -135,7 +145,7 @@ public:
 	Image(const TSize *size, const TSpacing *spacing, const T *data);
 
 	///Destructor (delete the buffer)
-	~Image() { if(this->data!=0) delete[] this->data; data=0;}
+	~Image() { releaseData(); }
 
 	///Copy constructor
 	Image(const Image<T> &im);
@@ -156,12 +166,8 @@ public:
 			this->size[0]=size[0];
 			this->size[1]=size[1];
 			this->size[2]=size[2];
-			this->dataSize=this->size[0]*this->size[1]*this->size[2];
-			if(this->data != 0)
-				{
-				delete[] this->data;
-				this->data=0;
-				}
+			this->dataSize=(TOffset)this->size[0]*this->size[1]*this->size[2];
+			releaseData();
 
 			try {
 				this->data = new T [this->dataSize];
@@ -177,12 +183,8 @@ public:
 			this->size[0]=x;
 			this->size[1]=y;
 			this->size[2]=z;
-			this->dataSize=this->size[0]*this->size[1]*this->size[2];
-			if(this->data != 0)
-				{
-				delete[] this->data;
-				this->data=0;
-				}
+			this->dataSize=(TOffset)this->size[0]*this->size[1]*this->size[2];
+			releaseData();
 			try {
 				this->data = new T [this->dataSize];
 				}
@@ -193,6 +195,21 @@ public:
   				}
 			}
 
+	///Read only 2D view on an external buffer of xSize*ySize values, which must outlive the image
+	///(the buffer is neither copied nor deleted, and must not be written through the image)
+	void setView(TSize xSize, TSize ySize, const T *buffer)
+			{
+			releaseData();
+			this->size[0]=xSize;
+			this->size[1]=ySize;
+			this->size[2]=1;
+			this->dataSize=(TOffset)this->size[0]*this->size[1];
+			for (int i = 0; i < 3; i++) this->spacing[i]=1.0;
+			this->data=const_cast<T *>(buffer);
+			ownsData=false;
+			}
+	bool isView() const {return !ownsData;}
+
 	const TSpacing *getSpacing() const {return spacing;}
 	const TSpacing &getSpacingX() const {return spacing[0];}
 	const TSpacing &getSpacingY() const {return spacing[1];}
@@ -209,6 +226,7 @@ public:
 	const TOffset &getBufSize() const {return dataSize;}
 
 	inline  T *getData() {return this->data;}
+	inline  const T *getData() const {return this->data;}
 
 	///Iterators
 	typedef ImageIterator <Image,T> iterator;
@@ -235,10 +253,10 @@ public:
 	///Unsafe data accessors
 
 	///Coordinates write version
-	inline T &operator()(TCoord x, TCoord y, TCoord z=0) {return data[x + y*size[0] + z*size[0]*size[1]];}
+	inline T &operator()(TCoord x, TCoord y, TCoord z=0) {return data[x + (TOffset)y*size[0] + (TOffset)z*size[0]*size[1]];}
 
 	///Coordinates read-only version
-	inline T operator()(TCoord x, TCoord y, TCoord z=0) const {return data[x + y*size[0] + z*size[0]*size[1]];}
+	inline T operator()(TCoord x, TCoord y, TCoord z=0) const {return data[x + (TOffset)y*size[0] + (TOffset)z*size[0]*size[1]];}
 
 	///Offset write version
 	inline T &operator()(TOffset offset) {return data[offset];}
@@ -247,10 +265,10 @@ public:
 	inline T operator()(TOffset offset) const {return data[offset];}
 
 	///Point write version
-	inline T &operator()(Point <TCoord> p) {return data[p.x + p.y*size[0] + p.z*size[0]*size[1]];}
+	inline T &operator()(Point <TCoord> p) {return data[p.x + (TOffset)p.y*size[0] + (TOffset)p.z*size[0]*size[1]];}
 
 	///Point read-only version
-	inline T operator()(Point <TCoord> p) const {return data[p.x + p.y*size[0] + p.z*size[0]*size[1]];}
+	inline T operator()(Point <TCoord> p) const {return data[p.x + (TOffset)p.y*size[0] + (TOffset)p.z*size[0]*size[1]];}
 
 	///Operators overloading
 
@@ -312,9 +330,9 @@ public:
 
 	void enlarge();
 
-	int getOffset(TCoord x, TCoord y=0, TCoord z=0) {return x+y*size[0]+z*size[0]*size[1];}
+	TOffset getOffset(TCoord x, TCoord y=0, TCoord z=0) {return x+(TOffset)y*size[0]+(TOffset)z*size[0]*size[1];}
 
-	int getOffset(Point <TCoord> p) {return p.x+p.y*size[0]+p.z*size[0]*size[1];}
+	TOffset getOffset(Point <TCoord> p) {return p.x+(TOffset)p.y*size[0]+(TOffset)p.z*size[0]*size[1];}
 
 	const Point<TCoord> getCoord  (TOffset offset) const {
 		Point <TCoord> res;
@@ -376,7 +394,7 @@ template <class T>
 Image <T> operator+(Image <T> &a, T s)
 {
 	Image <T> res=a;
-	for(int i=0; i<a.getBufSize(); i++)
+	for(TOffset i=0; i<a.getBufSize(); i++)
 		res(i)+=s;
 	return res;
 }
@@ -385,7 +403,7 @@ template <class T>
 Image <T> operator-(Image <T> &a, T s)
 {
 	Image <T> res=a;
-	for(int i=0; i<a.getBufSize(); i++)
+	for(TOffset i=0; i<a.getBufSize(); i++)
 		res(i)-=s;
 	return res;
 }
@@ -394,7 +412,7 @@ template <class T>
 Image <T> operator*(Image <T> &a, T s)
 {
 	Image <T> res=a;
-	for(int i=0; i<a.getBufSize(); i++)
+	for(TOffset i=0; i<a.getBufSize(); i++)
 		res(i)*=s;
 	return res;
 }
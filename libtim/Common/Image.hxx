@@ -23,10 +23,10 @@
 
 namespace LibTIM {
 
-static int getOffset(int x,  int y, int z,
+static TOffset getOffset(int x,  int y, int z,
 			         int tx, int ty)
 {
-	return x + y*tx + z*tx*ty;
+	return x + (TOffset)y*tx + (TOffset)z*tx*ty;
 }
 
 
@@ -55,7 +55,7 @@ Image<T>::Image(const TSize *size)
 		this->spacing[i] = 1.0;
 	}
 	
-	this->dataSize=this->size[0]*this->size[1]*this->size[2];
+	this->dataSize=(TOffset)this->size[0]*this->size[1]*this->size[2];
 	try {
 		this->data = new T [this->dataSize];
 		}
@@ -80,7 +80,7 @@ Image<T>::Image(const TSize xSize, const TSize ySize, const TSize zSize)
 		this->spacing[i] = 1.0;
 	}
 	
-	this->dataSize=this->size[0]*this->size[1]*this->size[2];
+	this->dataSize=(TOffset)this->size[0]*this->size[1]*this->size[2];
 	try {
 		this->data = new T [this->dataSize];
 		}
@@ -98,7 +98,7 @@ Image<T>::Image(const TSize *size, const TSpacing *spacing, const T *data)
 {
 	for (int i = 0; i < 3; i++) this->size[i] = size[i];
 	for (int i = 0; i < 3; i++) this->spacing[i] = spacing[i];
-	this->dataSize=this->size[0]*this->size[1]*this->size[2];
+	this->dataSize=(TOffset)this->size[0]*this->size[1]*this->size[2];
 	
 	try {
 		this->data=new T [this->dataSize];
@@ -109,7 +109,7 @@ Image<T>::Image(const TSize *size, const TSpacing *spacing, const T *data)
     	exit(-1);
   		}
 	
-	for(int i=0; i<this->dataSize; i++) this->data[i]=data[i];
+	for(TOffset i=0; i<this->dataSize; i++) this->data[i]=data[i];
 }
 
 //Copy ctor
@@ -119,7 +119,7 @@ Image<T>::Image(const Image<T> &im)
 	for (int i = 0; i < 3; i++) this->size[i] = im.size[i];
 	for (int i = 0; i < 3; i++) this->spacing[i] = im.spacing[i];
 	
-	dataSize=im.size[0]*im.size[1]*im.size[2];
+	dataSize=(TOffset)im.size[0]*im.size[1]*im.size[2];
 	try {
 		this->data=new T [this->dataSize];
 		}
@@ -129,7 +129,7 @@ Image<T>::Image(const Image<T> &im)
     	exit(-1);
   		}
 
-	for (int i=0; i<this->dataSize; i++)
+	for (TOffset i=0; i<this->dataSize; i++)
 		data[i] = im.data[i];
 }
 
@@ -141,12 +141,8 @@ Image <T> & Image<T>::operator=(const Image <T> &im)
 		{
 		for (int i = 0; i < 3; i++) this->size[i] = im.size[i];
 		for (int i = 0; i < 3; i++) this->spacing[i] = im.spacing[i];
-		if(this->data != 0)
-			{
-			delete[] this->data;
-			this->data=0;
-			}
-		this->dataSize=im.size[0]*im.size[1]*im.size[2];
+		releaseData();
+		this->dataSize=(TOffset)im.size[0]*im.size[1]*im.size[2];
 		try {
 			this->data=new T [this->dataSize];
 			}
@@ -156,7 +152,7 @@ Image <T> & Image<T>::operator=(const Image <T> &im)
     		exit(-1);
   			}
 
-		for (int i=0; i<this->dataSize; i++)
+		for (TOffset i=0; i<this->dataSize; i++)
 			this->data[i] = im.data[i];
 		}
 	return *this;
@@ -177,7 +173,7 @@ Image<T>::Image( const Image<T2> &im)
 	this->spacing[1]=im.getSpacingY();
 	this->spacing[2]=im.getSpacingZ();
 	
-	this->dataSize=this->size[0]*this->size[1]*this->size[2];
+	this->dataSize=(TOffset)this->size[0]*this->size[1]*this->size[2];
 	try {
 		this->data=new T [this->dataSize];
 		}
@@ -187,7 +183,7 @@ Image<T>::Image( const Image<T2> &im)
     	exit(-1);
   		}
 	
-	for (int i=0; i < this->dataSize; i++)
+	for (TOffset i=0; i < this->dataSize; i++)
 		this->data[i] = static_cast<T> (im(i));
 }
 
@@ -196,7 +192,7 @@ Image<T>::Image( const Image<T2> &im)
 template <class T>
 Image <T> &Image<T>::operator+=(Image <T> &op)
 {
-	for(int i=0; i<dataSize; i++)
+	for(TOffset i=0; i<dataSize; i++)
 		this->data[i]+=op(i);
 	return *this;
 }
@@ -204,7 +200,7 @@ Image <T> &Image<T>::operator+=(Image <T> &op)
 template <class T>
 Image <T> &Image<T>::operator-=(Image <T> &op)
 {
-	for(int i=0; i<dataSize; i++)
+	for(TOffset i=0; i<dataSize; i++)
 		this->data[i]-=op(i);
 	return *this;
 }
@@ -212,7 +208,7 @@ Image <T> &Image<T>::operator-=(Image <T> &op)
 template <class T>
 Image <T> &Image<T>::operator*=(Image <T> &op)
 {
-	for(int i=0; i<dataSize; i++)
+	for(TOffset i=0; i<dataSize; i++)
 		this->data[i]*=op(i);
 	return *this;
 }
@@ -220,7 +216,7 @@ Image <T> &Image<T>::operator*=(Image <T> &op)
 template <class T>
 Image <T> &Image<T>::operator&=(Image <T> &op)
 {
-	for(int i=0; i<dataSize; i++)
+	for(TOffset i=0; i<dataSize; i++)
 		this->data[i]=std::min(this->data[i],op(i));
 	return *this;
 }
@@ -228,7 +224,7 @@ Image <T> &Image<T>::operator&=(Image <T> &op)
 template <class T>
 Image <T> &Image<T>::operator|=(Image <T> &op)
 {
-	for(int i=0; i<dataSize; i++)
+	for(TOffset i=0; i<dataSize; i++)
 		this->data[i]=std::max(this->data[i],op(i));
 	return *this;
 }
@@ -239,7 +235,7 @@ Image <T> &Image<T>::operator!()
 	T max=std::numeric_limits<T>::max();
 	T min=std::numeric_limits<T>::min();
 	
-	for(int i=0; i<this->dataSize; i++)
+	for(TOffset i=0; i<this->dataSize; i++)
 		this->data[i]=max+min-this->data[i];
 	return *this;
 }
@@ -249,7 +245,7 @@ template <class T>
 T Image<T>::getMax(void) const
 { 
 T max=std::numeric_limits<T>::min(); 
-for (int i=0;i<dataSize; i++) 
+for (TOffset i=0;i<dataSize; i++) 
 	if(this->data[i]>max) 
 		max=this->data[i]; 
 return max;
@@ -259,7 +255,7 @@ template <class T>
 T Image<T>::getMin(void) const
 { 
 T min=std::numeric_limits<T>::max(); 
-for (int i=0;i<this->dataSize; i++) 
+for (TOffset i=0;i<this->dataSize; i++) 
 	if(this->data[i]<min) 
 		min=this->data[i]; 
 return min;
@@ -270,7 +266,7 @@ return min;
 template <class T> 
 void Image<T>::fill(const T value)
 {
-	for(int i=0; i<this->dataSize; i++)
+	for(TOffset i=0; i<this->dataSize; i++)
 		this->data[i]=value;
 }
 
@@ -22,6 +22,7 @@
 #include <string>
 #include <sstream>
 #include <stdlib.h>
+#include <algorithm>
 
 namespace LibTIM {
     
@@ -84,12 +85,12 @@ namespace LibTIM {
             return 0;
         }
         else {
-            if(im.data!=0) delete[] im.data;
+            im.releaseData();
             
             im.size[0] = width;
             im.size[1] = height;
             im.size[2] = 1;
-            im.dataSize=width*height*1;
+            im.dataSize=(TOffset)width*height;
             
             for (int i = 0; i < 3; i++)
             {
@@ -123,18 +124,98 @@ namespace LibTIM {
             return 0;
         }
         else {
-            if(im.data!=(U16*)(0)) delete[] im.data;
+            im.releaseData();
             
             im.size[0] = width;
             im.size[1] = height;
             im.size[2] = 1;
-            im.dataSize=width*height*1;
+            im.dataSize=(TOffset)width*height;
             for (int i = 0; i < 3; i++)
             {
                 im.spacing[i] = 1.0;
             }
             im.data = new U16 [im.dataSize];
-            file.read(reinterpret_cast<char *> (im.data),im.dataSize);
+            if(colormax < 256)
+            {
+                //One byte per sample
+                U8 *buf=new U8[im.dataSize];
+                file.read(reinterpret_cast<char *> (buf),im.dataSize);
+                for(TOffset i=0; i<im.dataSize; i++) im.data[i]=buf[i];
+                delete[] buf;
+            }
+            else
+            {
+                //Two bytes per sample, most significant byte first
+                U8 *buf=new U8[im.dataSize*2];
+                file.read(reinterpret_cast<char *> (buf),im.dataSize*2);
+                for(TOffset i=0; i<im.dataSize; i++) im.data[i]=(U16)((buf[2*i]<<8) | buf[2*i+1]);
+                delete[] buf;
+            }
+        }
+        file.close();
+        return 1;
+    }
+    
+    ///Grayscale PFM reader ("Pf", negative scale for little endian data, rows stored bottom to top)
+    template <>
+    inline int Image<float>::load(const char*filename, Image <float> &im)
+    {
+        std::ifstream file(filename,std::ios_base::in  | std::ios_base::binary);
+        if(!file)
+        {
+            std::cerr << "Image file I/O error\n";
+            return 0;
+        }
+        std::string format;
+        unsigned int width,height;
+        float scale;
+        
+        format=GImageIO_NextLine(file);
+        std::stringstream str_stream(GImageIO_NextLine(file));
+        str_stream>> width;
+        str_stream.clear();
+        str_stream.str(GImageIO_NextLine(file));
+        str_stream>> height;
+        str_stream.clear();
+        str_stream.str(GImageIO_NextLine(file));
+        str_stream>> scale;
+        
+        if(format!="Pf")
+        {
+            std::cerr<< "Error: image is not a grayscale .pfm\n";
+            file.close();
+            return 0;
+        }
+        
+        im.releaseData();
+        
+        im.size[0] = width;
+        im.size[1] = height;
+        im.size[2] = 1;
+        im.dataSize=(TOffset)width*height;
+        for (int i = 0; i < 3; i++)
+        {
+            im.spacing[i] = 1.0;
+        }
+        im.data = new float [im.dataSize];
+        
+        const unsigned int one = 1;
+        bool littleEndianHost = *reinterpret_cast<const U8 *>(&one) == 1;
+        bool swap = (scale < 0) != littleEndianHost;
+        
+        for(unsigned int y=0; y<height; y++)
+        {
+            float *row=im.data+(TOffset)(height-1-y)*width;
+            file.read(reinterpret_cast<char *> (row),width*sizeof(float));
+            if(swap)
+            {
+                for(unsigned int x=0; x<width; x++)
+                {
+                    U8 *b=reinterpret_cast<U8 *>(row+x);
+                    std::swap(b[0],b[3]);
+                    std::swap(b[1],b[2]);
+                }
+            }
         }
         file.close();
         return 1;
@@ -161,12 +242,12 @@ namespace LibTIM {
             return 0;
         }
         else {
-            if(im.data!=(RGB*)(0)) delete[] im.data;
+            im.releaseData();
             
             im.size[0] = width;
             im.size[1] = height;
             im.size[2] = 1;
-            im.dataSize=width*height;
+            im.dataSize=(TOffset)width*height;
             for (int i = 0; i < 3; i++)
             {
                 im.spacing[i] = 1.0;
@@ -196,7 +277,7 @@ namespace LibTIM {
         int width=getSizeX();
         int height=getSizeY();
         
-        int buf_size = width*height;
+        TOffset buf_size = (TOffset)width*height;
                 
         file << "P5\n#CREATOR: GImage \n" << width << " " << height << "\n" << "255" ;
         file << "\n";
@@ -210,7 +291,7 @@ namespace LibTIM {
         return 1;
     }
     
-    ///Pgm writer
+    ///Pgm writer, two bytes per sample, most significant byte first
     template <>
     inline int Image <U16>::save( const char *filename) {
         std::ofstream file(filename,std::ios_base::trunc  | std::ios_base::binary);
@@ -219,19 +300,27 @@ namespace LibTIM {
             std::cerr << "Image file I/O error\n";
             return 0;
         }
-        std::string str;
-        std::string format;
         
         int width=getSizeX();
         int height=getSizeY();
         
-        int buf_size = width*height*sizeof(U16);
-        
-        int maxVal=(int)(this->getMax());
+        //A maximum value below 256 would mean one byte per sample
+        int maxVal=std::max((int)(this->getMax()),256);
         
         file << "P5\n#CREATOR: GImage \n" << width << " " << height << "\n" << maxVal << "\n" ;
         
-        file.write(reinterpret_cast<char *> (this->data),buf_size);
+        U8 *buf=new U8[(TOffset)width*2];
+        for(int y=0; y<height; y++)
+        {
+            const U16 *row=this->data+(TOffset)y*width;
+            for(int x=0; x<width; x++)
+            {
+                buf[2*x]=(U8)(row[x]>>8);
+                buf[2*x+1]=(U8)(row[x]&0xFF);
+            }
+            file.write(reinterpret_cast<char *> (buf),(TOffset)width*2);
+        }
+        delete[] buf;
         
         file << "\n";
         
@@ -241,6 +330,34 @@ namespace LibTIM {
         
     }
     
+    ///Grayscale PFM writer, host byte order, rows stored bottom to top
+    template <>
+    inline int Image <float>::save( const char *filename) {
+        std::ofstream file(filename,std::ios_base::trunc  | std::ios_base::binary);
+        if(!file)
+        {
+            std::cerr << "Image file I/O error\n";
+            return 0;
+        }
+        
+        int width=getSizeX();
+        int height=getSizeY();
+        
+        const unsigned int one = 1;
+        bool littleEndianHost = *reinterpret_cast<const U8 *>(&one) == 1;
+        
+        file << "Pf\n" << width << " " << height << "\n" << (littleEndianHost ? "-1.0" : "1.0") << "\n" ;
+        
+        for(int y=height-1; y>=0; y--)
+        {
+            file.write(reinterpret_cast<char *> (this->data+(TOffset)y*width),(TOffset)width*sizeof(float));
+        }
+        
+        file.close();
+        
+        return 1;
+    }
+    
     template <>
     inline int Image <RGB>::save( const char *filename) {
         std::ofstream file(filename,std::ios_base::trunc  | std::ios_base::binary);
@@ -256,13 +373,13 @@ namespace LibTIM {
         int width=getSizeX();
         int height=getSizeY();
         
-        int buf_size = width*height*3;
+        TOffset buf_size = (TOffset)width*height*3;
         
         file << "P6\n#CREATOR: GImage \n" << width << " " << height << "\n" << "255\n" ;
         
-        U8 *buf=new U8[width*height*3];
+        U8 *buf=new U8[buf_size];
         
-        for(int i=0; i<width*height; i++)
+        for(TOffset i=0; i<(TOffset)width*height; i++)
         {
             buf[i*3]=(*this)(i)[0];
             buf[i*3+1]=(*this)(i)[1];
@@ -477,7 +477,7 @@ int Image<T>::loadInrGz(const char *fileName, Image<T> &image)
     
     // Header is loaded, now let's take care of the buffer
     CBufferIO_InrImage<T> bLoader(&stream);
-    if(image.data != static_cast<T*>(0)) delete[] image.data;
+    image.releaseData();
     image.data = bLoader.load(image.getBufSize());
     
     stream.close();
@@ -21,6 +21,8 @@
 #ifndef Types_h
 #define Types_h
 
+#include <cstddef>
+
 namespace LibTIM 
 {
 //Machine dependant typedefs
@@ -54,8 +56,8 @@ struct Table{
 //Type of RGB point
 typedef Table<U8,3> RGB;
 
-//Type of image size 
-typedef unsigned short TSize;
+//Type of image size (along one axis)
+typedef unsigned int TSize;
 
 //Type of point spacing
 typedef double TSpacing;
@@ -66,8 +68,8 @@ typedef int TCoord;
 //Type of label
 typedef unsigned long TLabel;
 
-//Type of offset
-typedef  long TOffset;
+//Type of offset (64 bits on 64-bit platforms, for images of more than 2^31 points)
+typedef std::ptrdiff_t TOffset;
 
 const float FLOAT_EPSILON=0.0000000001f;
 }
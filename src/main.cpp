@@ -1,26 +1,131 @@
+#include "filter.h"
 #include "img_handler.h"
+#include "pnm_file.h"
 #include "pqueue.h"
+#include "profiler.h"
 #include "svm_cell.h"
 #include "svm_img.h"
 #include "tos.h"
 #include <Common/Image.h>
 #include <SFML/Graphics.hpp>
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <dirent.h>
+#include <fstream>
 #include <getopt.h>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <omp.h>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
 
 void drawUI(sf::RenderWindow &window, const sf::View &view);
 
+// map or read the image file <filename> and parse its header, as the "read" stage of the profiler
+bool openImage(const char *filename, PNMFile &file);
+
+// command line options
+struct Options
+{
+    bool uninterpolate = true;
+    bool display = false;
+    bool implicit = false;
+    bool rank = false;
+    unsigned int jobs = 1;
+    unsigned int connectivity = 8;
+    const char *exportFile = nullptr; // output directory in batch mode
+    const char *batch = nullptr;
+    unsigned int workers = 0; // 0: one per core
+    bool profile = false;
+    const char *statsFile = nullptr;
+    bool stream = false;
+    std::vector<FilterCriterion> criteria; // grain filter, empty if none
+    const char *output = nullptr;          // image reconstructed from the (filtered) tree
+};
+
+// result of one image of a batch
+struct BatchResult
+{
+    std::string filename;
+    bool ok = false;
+    std::size_t width = 0, height = 0;
+    std::size_t nodes = 0;
+    double loadTime = 0, treeTime = 0; // milliseconds
+};
+
+// pixels of <file> in <im> (a view on the file for a binary 8-bit PGM), as the "load" stage of the profiler
+template <typename T>
+bool loadImage(const PNMFile &file, LibTIM::Image<T> &im);
+
+// print and write the profiler report, if asked
+void report(const Options &options);
+
+// filter the tree with <options.criteria> and write the reconstructed image to <options.output>
+template <typename T>
+bool filterImage(const TOS<T> &tree, const Options &options);
+
+// compute (and display) the tree of shape of <im>
+template <typename T>
+int run(const LibTIM::Image<T> &im, std::chrono::high_resolution_clock::time_point start, const Options &options);
+
+// images of a batch: the files of a directory, or the lines of a list file
+std::vector<std::string> batchFiles(const char *path);
+// process all the images of a batch on <options.workers> threads, printing one line per image
+int runBatch(const Options &options);
+void processFile(const Options &options, BatchResult &result);
+template <typename T>
+void processImage(const LibTIM::Image<T> &im, const Options &options, BatchResult &result);
+
+// image of a stream, loaded by the reader thread in the image matching its depth
+struct StreamImage
+{
+    PNMFile file;
+    LibTIM::Image<LibTIM::U8> imageU8;
+    LibTIM::Image<LibTIM::U16> imageU16;
+    LibTIM::Image<float> imageFloat;
+    bool ok = false;
+};
+
+// read the images concatenated on stdin while the tree of the previous one is computed,
+// writing one tree record per image on stdout
+int runStream(const Options &options);
+// read and load the next image of stdin
+void readStreamImage(StreamImage &image);
+// compute the tree of <im> and write its record on stdout
+template <typename T>
+bool streamImage(const LibTIM::Image<T> &im, const Options &options, std::size_t index);
+
 void help()
 {
     std::cout << BOLD_ON << "\nUsage:\n"
               << RESET
               << " tos [options] infile [options]\n\n"
-              << "Compute infile's tree of shape.\n\n"
+              << "Compute infile's tree of shape, infile being a 8 or 16 bits PGM (binary or ASCII) or a grayscale float PFM.\n\n"
               << BOLD_ON << "Options\n"
               << RESET
               << " -n, --no-uninterpolation Deactivate the uninterpolation step\n"
+              << " -i, --implicit           Compute the interpolated cells on the fly instead of storing them\n"
+              << " -r, --rank               Build the tree on the ranks of the values (always on for float images)\n"
+              << " -j, --jobs <n>           Build the tree on <n> tiles in parallel\n"
+              << " -c, --connectivity <c>   Neighbourhood of the interpolated cells, 4 or 8 (default); changes the tree of -n only\n"
+              << " -e, --export <file>      Write the tree to <file> (.tos binary format), to directory <file> in batch mode\n"
+              << " -b, --batch <path>       Process the images of directory <path>, or listed in file <path>\n"
+              << " -w, --workers <n>        Number of images processed in parallel in batch mode (default: one per core)\n"
+              << " -s, --stream             Read images concatenated on stdin, write one tree record (.tos) per image on stdout\n"
+              << " -F, --filter <criteria>  Remove the shapes not matching all the criteria, as area>=100,contrast>10\n"
+              << "                          (area, contrast, contour, inertia, mean, variance, depth; <, <=, >, >=)\n"
+              << " -o, --output <file>      Write the image reconstructed from the filtered tree to <file> (PGM or PFM)\n"
               << " -f, --file <infile>      The file to process, ignore non-option infile\n"
+              << " -p, --profile            Display the time, memory and item counts of each stage\n"
+              << "     --stats=<file>       Write the profile of each stage to <file> (JSON)\n"
               << " -v, --verbose            Display step description output\n"
               << " -d, --display            Open the graphical interface\n\n"
               << " -h, --help               Display this help\n"
@@ -31,13 +136,24 @@ void help()
 int main(int argc, char *argv[])
 {
     bool file_provided = false;
-    bool uninterpolate = true;
-    bool display = false;
+    Options options;
     int file_arg_pos = 1;
 
     static struct option long_options[] = {
         {"no-uninterpolation", no_argument, nullptr, 'n'},
+        {"implicit", no_argument, nullptr, 'i'},
+        {"rank", no_argument, nullptr, 'r'},
+        {"jobs", required_argument, nullptr, 'j'},
+        {"connectivity", required_argument, nullptr, 'c'},
+        {"export", required_argument, nullptr, 'e'},
+        {"batch", required_argument, nullptr, 'b'},
+        {"workers", required_argument, nullptr, 'w'},
+        {"stream", no_argument, nullptr, 's'},
+        {"filter", required_argument, nullptr, 'F'},
+        {"output", required_argument, nullptr, 'o'},
         {"file", required_argument, nullptr, 'f'},
+        {"profile", no_argument, nullptr, 'p'},
+        {"stats", required_argument, nullptr, 'S'},
         {"verbose", no_argument, nullptr, 'v'},
         {"display", no_argument, nullptr, 'd'},
         {"help", no_argument, nullptr, 'h'},
@@ -52,26 +168,71 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
-    while ((c = getopt_long(argc, argv, "nf:hVvd", long_options, nullptr)) != -1)
+    while ((c = getopt_long(argc, argv, "nirj:c:e:b:w:sF:o:pf:hVvd", long_options, nullptr)) != -1)
     {
         // Option argument
         switch (c)
         {
         case 'n': // No uninterpolation
-            uninterpolate = false;
+            options.uninterpolate = false;
+            break;
+        case 'i': // compute the interpolated cells on the fly
+            options.implicit = true;
+            break;
+        case 'r': // rank transform of the values
+            options.rank = true;
+            break;
+        case 'j': // number of tiles computed in parallel
+            options.jobs = std::max(1, atoi(optarg));
+            break;
+        case 'c': // 4 or 8 connectivity
+            options.connectivity = atoi(optarg);
+            if (options.connectivity != 4 && options.connectivity != 8)
+            {
+                std::cout << "Connectivity must be 4 or 8" << std::endl;
+                exit(EXIT_FAILURE);
+            }
             break;
         case 'h': // display help
             help();
             exit(EXIT_SUCCESS);
+        case 'p': // profile table
+            options.profile = true;
+            break;
+        case 'S': // profile report
+            options.statsFile = optarg;
+            break;
         case 'v': // verbose
             verbose = true;
             break;
         case 'd': // verbose
-            display = true;
+            options.display = true;
             break;
         case 'V': // display version
             std::cout << "tos, Tree of Shape, by Méline Bourg-Lang, Morgane Ritter & Nathan Roth" << std::endl;
             exit(EXIT_SUCCESS);
+        case 'e': // tree export
+            options.exportFile = optarg;
+            break;
+        case 'b': // batch mode
+            options.batch = optarg;
+            break;
+        case 'w': // batch workers
+            options.workers = std::max(1, atoi(optarg));
+            break;
+        case 's': // stdin/stdout stream
+            options.stream = true;
+            break;
+        case 'F': // grain filter
+            if (!parseFilter(optarg, options.criteria))
+            {
+                std::cout << "Invalid filter: " << optarg << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'o': // reconstructed image
+            options.output = optarg;
+            break;
         case 'f':
             file_provided = true;
             file_arg_pos = optind - 1;
@@ -82,6 +243,28 @@ int main(int argc, char *argv[])
         }
     }
 
+    Profiler::instance().enable(options.profile || options.statsFile);
+
+    if (!options.criteria.empty() && !options.output)
+    {
+        std::cout << "--filter needs an output image (--output)" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if (options.output && (options.batch || options.stream))
+    {
+        std::cout << "--output is not available in batch and stream modes" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    if (options.batch)
+    {
+        return runBatch(options);
+    }
+    if (options.stream)
+    {
+        return runStream(options);
+    }
+
     if (optind == argc - 1 && file_provided == false)
     {
         file_provided = true;
@@ -103,37 +286,338 @@ int main(int argc, char *argv[])
     auto start = std::chrono::high_resolution_clock::now();
 
     // Image is a generic class templated by the image points' type
-    LibTIM::Image<unsigned char> im;
-    if (LibTIM::Image<LibTIM::U8>::load(argv[file_arg_pos], im))
+    const char *filename = argv[file_arg_pos];
+    PNMFile file;
+    if (!openImage(filename, file))
+    {
+        return EXIT_FAILURE;
+    }
+    // SVMImage throws length_error for the images it cannot represent
+    try
+    {
+        switch (file.depth())
+        {
+        case 8:
+        {
+            LibTIM::Image<LibTIM::U8> im;
+            if (!loadImage(file, im))
+            {
+                return EXIT_FAILURE;
+            }
+            VERBOSE("8 bits PGM image is loaded\n")
+            return run(im, start, options);
+        }
+        case 16:
+        {
+            LibTIM::Image<LibTIM::U16> im;
+            if (!loadImage(file, im))
+            {
+                return EXIT_FAILURE;
+            }
+            VERBOSE("16 bits PGM image is loaded\n")
+            return run(im, start, options);
+        }
+        default:
+        {
+            LibTIM::Image<float> im;
+            if (!loadImage(file, im))
+            {
+                return EXIT_FAILURE;
+            }
+            VERBOSE("Float PFM image is loaded\n")
+
+            // the SVMImage always rank transforms float values
+            return run(im, start, options);
+        }
+        }
+    }
+    catch (const std::length_error &e)
+    {
+        std::cerr << filename << ": " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+bool openImage(const char *filename, PNMFile &file)
+{
+    Profiler::Scope stage("read");
+    if (!file.open(filename))
     {
-        VERBOSE("PGM image is loaded\n")
+        return false;
+    }
+    stage.items(file.width() * file.height());
+    VERBOSE((file.mapped() ? "Image file is mapped\n" : "Image file is read\n"))
+    return true;
+}
+
+std::vector<std::string> batchFiles(const char *path)
+{
+    std::vector<std::string> files;
+
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode))
+    {
+        DIR *dir = opendir(path);
+        if (!dir)
+        {
+            return files;
+        }
+        while (struct dirent *entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            std::size_t dot = name.rfind('.');
+            std::string ext = dot == std::string::npos ? "" : name.substr(dot);
+            if (ext == ".pgm" || ext == ".pfm")
+            {
+                files.push_back(std::string(path) + "/" + name);
+            }
+        }
+        closedir(dir);
+        std::sort(files.begin(), files.end());
     }
     else
     {
+        std::ifstream list(path);
+        std::string line;
+        while (std::getline(list, line))
+        {
+            if (!line.empty() && line[0] != '#')
+            {
+                files.push_back(line);
+            }
+        }
+    }
+    return files;
+}
+
+int runBatch(const Options &options)
+{
+    std::vector<std::string> files = batchFiles(options.batch);
+    if (files.empty())
+    {
+        std::cout << "No image to process in " << options.batch << std::endl;
         return EXIT_FAILURE;
     }
 
+    std::vector<BatchResult> results(files.size());
+    for (std::size_t i = 0; i < files.size(); i++)
+    {
+        results[i].filename = files[i];
+    }
+
+    int workers = options.workers ? options.workers : omp_get_max_threads();
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // the buffers of an image go back to the BufferPool and are reused by the next one
+#pragma omp parallel for num_threads(workers) schedule(dynamic, 1)
+    for (std::size_t i = 0; i < files.size(); i++)
+    {
+        processFile(options, results[i]);
+    }
+
+    auto stop = std::chrono::high_resolution_clock::now();
+    double duration = std::chrono::duration<double, std::milli>(stop - start).count();
+    BufferPool::instance().release();
+
+    std::size_t failed = 0;
+    std::cout << "file\twidth\theight\tnodes\tload_ms\ttree_ms\n";
+    for (const BatchResult &result : results)
+    {
+        if (!result.ok)
+        {
+            std::cout << result.filename << "\tfailed\n";
+            failed++;
+            continue;
+        }
+        std::cout << result.filename << "\t" << result.width << "\t" << result.height << "\t" << result.nodes << "\t"
+                  << result.loadTime << "\t" << result.treeTime << "\n";
+    }
+    std::cout << files.size() << " images (" << failed << " failed) processed in " << duration << " milliseconds on "
+              << workers << " worker(s)" << std::endl;
+    report(options);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+void processFile(const Options &options, BatchResult &result)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    const char *filename = result.filename.c_str();
+
+    PNMFile file;
+    if (!openImage(filename, file))
+    {
+        return;
+    }
+    try
+    {
+        switch (file.depth())
+        {
+        case 8:
+        {
+            LibTIM::Image<LibTIM::U8> im;
+            if (loadImage(file, im))
+            {
+                result.loadTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                processImage(im, options, result);
+            }
+            break;
+        }
+        case 16:
+        {
+            LibTIM::Image<LibTIM::U16> im;
+            if (loadImage(file, im))
+            {
+                result.loadTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                processImage(im, options, result);
+            }
+            break;
+        }
+        default:
+        {
+            LibTIM::Image<float> im;
+            if (loadImage(file, im))
+            {
+                result.loadTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                processImage(im, options, result);
+            }
+            break;
+        }
+        }
+    }
+    catch (const std::length_error &e)
+    {
+        std::cerr << filename << ": " << e.what() << std::endl;
+        result.ok = false;
+    }
+}
+
+template <typename T>
+bool loadImage(const PNMFile &file, LibTIM::Image<T> &im)
+{
+    Profiler::Scope stage("load");
+    if (!file.image(im))
+    {
+        std::cerr << "Invalid image pixels" << std::endl;
+        return false;
+    }
+    stage.items(static_cast<std::size_t>(im.getSizeX()) * im.getSizeY());
+    return true;
+}
+
+void report(const Options &options)
+{
+    if (options.profile)
+    {
+        // stdout carries the trees in stream mode
+        Profiler::instance().print(options.stream ? std::cerr : std::cout);
+    }
+    if (options.statsFile)
+    {
+        Profiler::instance().writeJson(options.statsFile);
+    }
+}
+
+template <typename T>
+void processImage(const LibTIM::Image<T> &im, const Options &options, BatchResult &result)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    SVMImage<T> svm_img(im, options.implicit, options.rank);
+    TOS<T> tree(svm_img, options.jobs, options.connectivity);
+    if (options.uninterpolate)
+        svm_img.uninterpolate(&tree);
+
+    result.treeTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    result.width = im.getSizeX();
+    result.height = im.getSizeY();
+    for (FaceIndex id : tree.order())
+    {
+        result.nodes += tree.isCanonical(id);
+    }
+    result.ok = true;
+
+    if (options.exportFile)
+    {
+        // <export dir>/<image name>.tos
+        std::string name = result.filename.substr(result.filename.rfind('/') + 1);
+        name = name.substr(0, name.rfind('.')) + ".tos";
+        result.ok = tree.save((std::string(options.exportFile) + "/" + name).c_str());
+    }
+}
+
+template <typename T>
+bool filterImage(const TOS<T> &tree, const Options &options)
+{
+    VERBOSE(YELLOW << "Tree filtering... ")
+    NodeTable<T> nodes(tree);
+    Attributes<T> attributes(nodes);
+    GrainFilter<T> filter(attributes, options.criteria);
+
+    LibTIM::Image<T> filtered;
+    filter.reconstruct(filtered);
+    VERBOSE(GREEN << "done.\n"
+                  << RESET)
+    std::cout << filter.keptCount() << " of " << nodes.size() << " shapes kept" << std::endl;
+
+    if (!filtered.save(options.output))
+    {
+        std::cerr << "Cannot write " << options.output << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+int run(const LibTIM::Image<T> &im, std::chrono::high_resolution_clock::time_point start, const Options &options)
+{
     VERBOSE(BLUE << "Creating SVM Object.\n")
-    SVMImage<LibTIM::U8> svm_img(im);
+    SVMImage<T> svm_img(im, options.implicit, options.rank);
     VERBOSE(GREEN << "SVM object created\n"
                   << RESET)
 
     VERBOSE(BLUE << "Creating tree of shape.\n")
-    TOS<LibTIM::U8> tree(svm_img);
+    TOS<T> tree(svm_img, options.jobs, options.connectivity);
     VERBOSE(GREEN << "Tree created\n"
                   << RESET)
 
+    // the contour length needs the interpolated tree
+    bool filterFirst = options.output && needsContour(options.criteria);
+    if (filterFirst && !filterImage(tree, options))
+    {
+        return EXIT_FAILURE;
+    }
+
     VERBOSE(YELLOW << "Image uninterpolation... ")
-    if (uninterpolate)
+    if (options.uninterpolate)
         svm_img.uninterpolate(&tree);
     VERBOSE(GREEN << "done.\n"
                   << RESET)
 
+    // a single image is processed: give the memory of the interpolated grid back to the system
+    BufferPool::instance().release();
+
     auto stop = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count();
     std::cout << "Tree computation executed in " << duration << " milliseconds" << std::endl;
 
-    if (display)
+    if (options.exportFile)
+    {
+        VERBOSE(YELLOW << "Tree export... ")
+        if (!tree.save(options.exportFile))
+        {
+            return EXIT_FAILURE;
+        }
+        VERBOSE(GREEN << "done.\n"
+                      << RESET)
+    }
+    if (options.output && !filterFirst && !filterImage(tree, options))
+    {
+        return EXIT_FAILURE;
+    }
+    report(options);
+
+    if (options.display)
     {
         sf::ContextSettings settings;
         settings.antialiasingLevel = 8;
@@ -145,7 +629,7 @@ int main(int argc, char *argv[])
 
         // Needed to render the SVMImage on the screen (as a texture on a sprite)
         VERBOSE(BLUE << "Image handler... ")
-        ImgHandler<LibTIM::U8> handler(svm_img);
+        ImgHandler<T> handler(svm_img);
         VERBOSE(GREEN << "initialized.\n")
 
         // Variables needed to compute mouse position changes (panning)
@@ -155,6 +639,12 @@ int main(int argc, char *argv[])
         // Flag which indicates when the lef button is in the down position
         bool mouseButtonDown = false;
 
+        // area slider on the resident tree, built on first use: Up and Down double and halve the threshold
+        std::unique_ptr<NodeTable<T>> nodes;
+        std::unique_ptr<Attributes<T>> attributes;
+        std::unique_ptr<IncrementalFilter<T>> slider;
+        LibTIM::Image<T> filtered;
+
         while (window.isOpen())
         {
 
@@ -173,6 +663,25 @@ int main(int argc, char *argv[])
                     case sf::Keyboard::Escape:
                         window.close();
                         break;
+                    case sf::Keyboard::Up:
+                    case sf::Keyboard::Down:
+                    {
+                        if (!slider)
+                        {
+                            nodes.reset(new NodeTable<T>(tree));
+                            attributes.reset(new Attributes<T>(*nodes));
+                            slider.reset(new IncrementalFilter<T>(*attributes, FilterCriterion::Area));
+                            slider->setThreshold(1, filtered);
+                        }
+                        double area = event.key.code == sf::Keyboard::Up ? slider->threshold() * 2 : std::max(1.0, slider->threshold() / 2);
+                        auto updateStart = std::chrono::high_resolution_clock::now();
+                        slider->setThreshold(area, filtered);
+                        handler.update(filtered, slider->changed());
+                        double updateTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - updateStart).count();
+                        std::cout << "area >= " << area << ": " << slider->keptCount() << " shapes kept, " << slider->changed().size()
+                                  << " pixels updated in " << updateTime << " ms" << std::endl;
+                        break;
+                    }
                     default:
                         break;
                     }
@@ -259,3 +768,163 @@ void drawUI(sf::RenderWindow &window, const sf::View &view)
     window.draw(X, 2, sf::Lines);
     window.draw(Y, 2, sf::Lines);
 }
+
+int runStream(const Options &options)
+{
+    // stdout only carries the tree records
+    verbose = false;
+
+    // images read ahead of the tree computation, nullptr at the end of the stream, shared with the
+    // reader thread
+    struct Queue
+    {
+        std::deque<std::unique_ptr<StreamImage>> images;
+        std::mutex mutex;
+        std::condition_variable changed;
+        bool stop = false;
+    };
+    const std::size_t readAhead = 2;
+    std::shared_ptr<Queue> queue = std::make_shared<Queue>();
+
+    std::thread reader([queue, readAhead]() {
+        bool more = true;
+        while (more)
+        {
+            std::unique_ptr<StreamImage> image;
+            if (!PNMFile::endOfStream(stdin))
+            {
+                image.reset(new StreamImage);
+                readStreamImage(*image);
+                // the stream cannot be resynchronized after an invalid image
+                more = image->ok;
+            }
+            else
+            {
+                more = false;
+            }
+
+            std::unique_lock<std::mutex> lock(queue->mutex);
+            queue->changed.wait(lock, [&]() { return queue->images.size() < readAhead || queue->stop; });
+            if (queue->stop)
+            {
+                return;
+            }
+            queue->images.push_back(std::move(image));
+            queue->changed.notify_all();
+        }
+    });
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::size_t index = 0;
+    bool ok = true;
+    while (true)
+    {
+        std::unique_ptr<StreamImage> image;
+        {
+            std::unique_lock<std::mutex> lock(queue->mutex);
+            queue->changed.wait(lock, [&]() { return !queue->images.empty(); });
+            image = std::move(queue->images.front());
+            queue->images.pop_front();
+            queue->changed.notify_all();
+        }
+        if (!image || !image->ok)
+        {
+            // end of the stream, or invalid image
+            ok = !image;
+            reader.join();
+            break;
+        }
+
+        try
+        {
+            switch (image->file.depth())
+            {
+            case 8:
+                ok = streamImage(image->imageU8, options, index);
+                break;
+            case 16:
+                ok = streamImage(image->imageU16, options, index);
+                break;
+            default:
+                ok = streamImage(image->imageFloat, options, index);
+                break;
+            }
+        }
+        catch (const std::length_error &e)
+        {
+            std::cerr << "image " << index << ": " << e.what() << std::endl;
+            ok = false;
+        }
+        if (!ok)
+        {
+            // the reader stops at its next queue access, but may be blocked on stdin meanwhile
+            std::unique_lock<std::mutex> lock(queue->mutex);
+            queue->stop = true;
+            queue->changed.notify_all();
+            break;
+        }
+        index++;
+    }
+
+    auto duration = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cerr << index << " images processed in " << duration << " milliseconds" << std::endl;
+    report(options);
+    if (reader.joinable())
+    {
+        // the reader cannot be joined without waiting for stdin, and must not outlive the Profiler and
+        // BufferPool singletons it uses: flush the outputs and exit without running the destructors
+        // (stdin is locked by the reader: only the output streams are flushed)
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(stdout);
+        std::fflush(stderr);
+        std::_Exit(EXIT_FAILURE);
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void readStreamImage(StreamImage &image)
+{
+    {
+        Profiler::Scope stage("read");
+        if (!image.file.read(stdin, "stdin"))
+        {
+            return;
+        }
+        stage.items(image.file.width() * image.file.height());
+    }
+    switch (image.file.depth())
+    {
+    case 8:
+        image.ok = loadImage(image.file, image.imageU8);
+        break;
+    case 16:
+        image.ok = loadImage(image.file, image.imageU16);
+        break;
+    default:
+        image.ok = loadImage(image.file, image.imageFloat);
+        break;
+    }
+}
+
+template <typename T>
+bool streamImage(const LibTIM::Image<T> &im, const Options &options, std::size_t index)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    SVMImage<T> svm_img(im, options.implicit, options.rank);
+    TOS<T> tree(svm_img, options.jobs, options.connectivity);
+    if (options.uninterpolate)
+        svm_img.uninterpolate(&tree);
+
+    if (!tree.save(std::cout) || !std::cout.flush())
+    {
+        std::cerr << "Tree stream I/O error" << std::endl;
+        return false;
+    }
+
+    auto duration = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cerr << "image " << index << ": " << im.getSizeX() << "x" << im.getSizeY() << ", tree in " << duration << " milliseconds"
+              << std::endl;
+    return true;
+}
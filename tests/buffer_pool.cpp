@@ -0,0 +1,73 @@
+// Regression test: reuse of the blocks of the BufferPool with small and large requests mixed,
+// as in batch and stream modes with images of different sizes. A small array must not take the
+// block of a large one, otherwise every large image allocates a new block and the pool grows.
+#include "buffer_pool.h"
+#include <cstdlib>
+#include <iostream>
+
+int failures = 0;
+
+void check(bool condition, const char *message)
+{
+    if (!condition)
+    {
+        std::cerr << "buffer_pool: " << message << std::endl;
+        failures++;
+    }
+}
+
+int main()
+{
+    BufferPool &pool = BufferPool::instance();
+    const std::size_t small = BufferPool::MIN_POOLED_BYTES;
+    const std::size_t large = 64 * BufferPool::MIN_POOLED_BYTES;
+
+    // a small request does not take a large free block
+    void *block = pool.allocate(large);
+    pool.deallocate(block, large);
+    void *s = pool.allocate(small);
+    check(s != block && pool.kept() == large, "a small request took a large block");
+    void *l = pool.allocate(large);
+    check(l == block && pool.kept() == 0, "a large request did not reuse the large block");
+    pool.deallocate(s, small);
+    pool.deallocate(l, large);
+    check(pool.kept() == small + large, "the blocks were not kept");
+    pool.release();
+
+    // a block is reused for requests down to 1 / MAX_REUSE_RATIO of its size
+    block = pool.allocate(large);
+    pool.deallocate(block, large);
+    void *half = pool.allocate(large / BufferPool::MAX_REUSE_RATIO);
+    check(half == block, "a block was not reused for a request of half its size");
+    pool.deallocate(half, large / BufferPool::MAX_REUSE_RATIO);
+    void *less = pool.allocate(large / BufferPool::MAX_REUSE_RATIO - 1);
+    check(less != block, "a block was reused for a request of less than half its size");
+    pool.deallocate(less, large / BufferPool::MAX_REUSE_RATIO - 1);
+    pool.release();
+
+    // a sequence of images, each one allocating a small array then a large one, while the small array
+    // of the previous image is still in use: the pool keeps one large block instead of growing
+    void *previousSmall = nullptr;
+    void *previousLarge = nullptr;
+    for (int image = 0; image < 16; image++)
+    {
+        if (previousLarge)
+        {
+            pool.deallocate(previousLarge, large);
+        }
+        void *a = pool.allocate(small);
+        void *b = pool.allocate(large);
+        if (previousSmall)
+        {
+            pool.deallocate(previousSmall, small);
+        }
+        previousSmall = a;
+        previousLarge = b;
+    }
+    pool.deallocate(previousSmall, small);
+    pool.deallocate(previousLarge, large);
+    check(pool.kept() <= large + 2 * small, "the pool grew with a sequence of mixed sizes");
+    pool.release();
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+// Regression test: value ranges of the Inter4 cells (0-faces) of the interpolated grid.
+// An Inter4 cell spans the ranges of its four Inter2 neighbours. It used to take the max of their
+// min values instead, which linked the shapes of this image wrongly:
+//
+//   30  0 60 60
+//   30  0  0 60     (border: median 30)
+//
+// The dark shape {0} and the bright shape {60} are adjacent sibling shapes inside the root, at
+// level 30: neither one encloses the other. The wrong ranges nested the dark shape inside the
+// bright one.
+#include "svm_img.h"
+#include "tos.h"
+#include <Common/Image.h>
+#include <cstdlib>
+#include <iostream>
+
+int main()
+{
+    const LibTIM::TSize width = 4, height = 2;
+    const LibTIM::U8 values[] = {30, 0, 60, 60,
+                                 30, 0, 0, 60};
+    LibTIM::Image<LibTIM::U8> im(width, height);
+    for (LibTIM::TSize y = 0; y < height; y++)
+    {
+        for (LibTIM::TSize x = 0; x < width; x++)
+        {
+            im(x, y) = values[y * width + x];
+        }
+    }
+
+    int failures = 0;
+    for (int implicit = 0; implicit < 2; implicit++)
+    {
+        SVMImage<LibTIM::U8> svm_img(im, implicit);
+        TOS<LibTIM::U8> tree(svm_img);
+        svm_img.uninterpolate(&tree);
+
+        // pixel [x,y] of the image is the cell [x+1,y+1] of the extended image
+        FaceIndex root = tree.order()[0];
+        FaceIndex dark = tree.parent(svm_img(2, 2));   // canonical face of the shape {0}
+        FaceIndex bright = tree.parent(svm_img(4, 2)); // canonical face of the shape {60}
+        if (tree.level(dark) != 0 || tree.level(bright) != 60 || tree.parent(dark) != root || tree.parent(bright) != root)
+        {
+            std::cerr << "inter4" << (implicit ? " (implicit)" : "") << ": shapes {0} and {60} are not both children of the root" << std::endl;
+            failures++;
+        }
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,235 @@
+// Synthetic image generator for stress and scaling tests of the tree of shapes.
+// Images are written row by row, so their size is not limited by the memory.
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+enum Pattern
+{
+    Noise,       // uniform random values: many small shapes
+    Ramp,        // diagonal ramp: one shape per level, long flat chains
+    Checker,     // checkerboard of <cell> pixels: wide and shallow tree
+    Rings,       // nested rings of <cell> pixels around the center: one level of the tree per ring
+    SaltPepper,  // ramp with a ratio <density> of pixels set to 0 or to the max value
+};
+
+struct Options
+{
+    std::size_t width = 1000, height = 1000;
+    unsigned int depth = 8;
+    Pattern pattern = Noise;
+    std::size_t cell = 8;
+    double density = 0.25;
+    unsigned long seed = 0;
+    bool raw = false;
+    const char *output = nullptr;
+};
+
+void help()
+{
+    std::cout << "Usage: tosgen [options] -o <file>\n\n"
+              << " -s, --size <w>x<h>     Image size (default 1000x1000)\n"
+              << " -d, --depth <8|16>     Bits per pixel (default 8)\n"
+              << " -p, --pattern <name>   noise, ramp, checker, rings or saltpepper (default noise)\n"
+              << " -c, --cell <n>         Size of the squares and width of the rings (default 8)\n"
+              << " -n, --density <ratio>  Ratio of salt and pepper pixels (default 0.25)\n"
+              << " -S, --seed <n>         Seed of the random patterns (default 0)\n"
+              << " -r, --raw              Write the samples only, without PGM header\n"
+              << " -o, --output <file>    Output file, - for the standard output\n"
+              << " -h, --help             Display this help\n\n"
+              << "16-bit samples are big endian, as in a PGM file, with or without --raw." << std::endl;
+}
+
+bool parsePattern(const char *name, Pattern &pattern)
+{
+    static const char *NAMES[] = {"noise", "ramp", "checker", "rings", "saltpepper"};
+    for (int i = 0; i < 5; i++)
+    {
+        if (strcmp(name, NAMES[i]) == 0)
+        {
+            pattern = static_cast<Pattern>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// fill <row> with the values of the row <y> of the image
+void generateRow(const Options &o, std::size_t y, unsigned int maxValue, std::mt19937_64 &rng, std::vector<unsigned int> &row)
+{
+    std::uniform_int_distribution<unsigned int> value(0, maxValue);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    double cx = (o.width - 1) / 2.0, cy = (o.height - 1) / 2.0;
+    std::size_t diagonal = std::max<std::size_t>(o.width + o.height - 2, 1);
+
+    for (std::size_t x = 0; x < o.width; x++)
+    {
+        switch (o.pattern)
+        {
+        case Noise:
+            row[x] = value(rng);
+            break;
+        case Ramp:
+            row[x] = static_cast<unsigned int>((x + y) * maxValue / diagonal);
+            break;
+        case Checker:
+            row[x] = ((x / o.cell + y / o.cell) & 1) ? maxValue : 0;
+            break;
+        case Rings:
+        {
+            // rings alternate between two levels, so that each one is a shape enclosing the next
+            std::size_t ring = static_cast<std::size_t>(std::hypot(x - cx, y - cy)) / o.cell;
+            row[x] = (ring & 1) ? maxValue / 4 : maxValue - maxValue / 4;
+            break;
+        }
+        case SaltPepper:
+        {
+            double u = uniform(rng);
+            if (u < o.density / 2)
+            {
+                row[x] = 0;
+            }
+            else if (u < o.density)
+            {
+                row[x] = maxValue;
+            }
+            else
+            {
+                row[x] = static_cast<unsigned int>((x + y) * maxValue / diagonal);
+            }
+            break;
+        }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Options o;
+
+    static struct option long_options[] = {
+        {"size", required_argument, nullptr, 's'},
+        {"depth", required_argument, nullptr, 'd'},
+        {"pattern", required_argument, nullptr, 'p'},
+        {"cell", required_argument, nullptr, 'c'},
+        {"density", required_argument, nullptr, 'n'},
+        {"seed", required_argument, nullptr, 'S'},
+        {"raw", no_argument, nullptr, 'r'},
+        {"output", required_argument, nullptr, 'o'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}};
+
+    int c;
+    while ((c = getopt_long(argc, argv, "s:d:p:c:n:S:ro:h", long_options, nullptr)) != -1)
+    {
+        switch (c)
+        {
+        case 's':
+        {
+            unsigned long long w, h;
+            if (sscanf(optarg, "%llux%llu", &w, &h) != 2 || w == 0 || h == 0)
+            {
+                std::cerr << "Invalid size: " << optarg << std::endl;
+                return EXIT_FAILURE;
+            }
+            o.width = w;
+            o.height = h;
+            break;
+        }
+        case 'd':
+            o.depth = atoi(optarg);
+            if (o.depth != 8 && o.depth != 16)
+            {
+                std::cerr << "Depth must be 8 or 16" << std::endl;
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'p':
+            if (!parsePattern(optarg, o.pattern))
+            {
+                std::cerr << "Unknown pattern: " << optarg << std::endl;
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'c':
+            o.cell = std::max(1, atoi(optarg));
+            break;
+        case 'n':
+            o.density = std::min(1.0, std::max(0.0, atof(optarg)));
+            break;
+        case 'S':
+            o.seed = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'r':
+            o.raw = true;
+            break;
+        case 'o':
+            o.output = optarg;
+            break;
+        case 'h':
+            help();
+            return EXIT_SUCCESS;
+        default:
+            help();
+            return EXIT_FAILURE;
+        }
+    }
+    if (!o.output)
+    {
+        help();
+        return EXIT_FAILURE;
+    }
+
+    FILE *out = strcmp(o.output, "-") == 0 ? stdout : fopen(o.output, "wb");
+    if (!out)
+    {
+        std::cerr << "Cannot open " << o.output << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    unsigned int maxValue = (1u << o.depth) - 1;
+    std::size_t bytes = o.depth / 8;
+    if (!o.raw)
+    {
+        fprintf(out, "P5\n%zu %zu\n%u\n", o.width, o.height, maxValue);
+    }
+
+    std::mt19937_64 rng(o.seed);
+    std::vector<unsigned int> row(o.width);
+    std::vector<unsigned char> buffer(o.width * bytes);
+    for (std::size_t y = 0; y < o.height; y++)
+    {
+        generateRow(o, y, maxValue, rng, row);
+        for (std::size_t x = 0; x < o.width; x++)
+        {
+            if (bytes == 2)
+            {
+                buffer[2 * x] = static_cast<unsigned char>(row[x] >> 8);
+                buffer[2 * x + 1] = static_cast<unsigned char>(row[x] & 0xFF);
+            }
+            else
+            {
+                buffer[x] = static_cast<unsigned char>(row[x]);
+            }
+        }
+        if (fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size())
+        {
+            std::cerr << "Write error on " << o.output << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return EXIT_SUCCESS;
+}